@@ -0,0 +1,51 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+// Small helpers shared by the benchmarks in bench/. Each benchmark is its own
+// program, linked against the server's objects, that prints one row per case
+// so a run can be diffed against the last one; see bench/run.sh.
+
+using BenchClock = std::chrono::steady_clock;
+
+// argv[index] as a count, or `fallback` when it is missing or not a number.
+inline std::size_t benchArg(const int argc, char **argv, const int index,
+                            const std::size_t fallback) noexcept {
+    if (index >= argc) {
+        return fallback;
+    }
+
+    char *end = nullptr;
+    const unsigned long long value = std::strtoull(argv[index], &end, 10);
+    if (end == argv[index] || *end != '\0' || value == 0) {
+        return fallback;
+    }
+
+    return static_cast<std::size_t>(value);
+}
+
+inline double benchSeconds(const BenchClock::time_point start) noexcept {
+    return std::chrono::duration<double>(BenchClock::now() - start).count();
+}
+
+// Keeps the compiler from dropping work whose result is otherwise unused.
+inline void benchKeep(const std::size_t value) noexcept {
+    static volatile std::size_t sink;
+    sink = sink + value;
+}
+
+inline void benchTitle(const char *title) noexcept {
+    std::printf("\n== %s\n", title);
+}
+
+inline void benchRow(const std::string &name, const double nsPerOp,
+                     const char *extra = "") noexcept {
+    std::printf("  %-36s %10.1f ns/op %s\n", name.c_str(), nsPerOp, extra);
+}
+
+#endif // !BENCH_HPP
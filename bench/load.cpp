@@ -0,0 +1,498 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "./Bench.hpp"
+
+// Drives a running server over loopback with many clients at once. Start
+// the server with flood control off (IRC_FLOOD_RATE=0), as bench/run.sh
+// does, or the scenarios measure the bucket instead of the server.
+//
+//   throughput [clients] [lines]   everyone joins one channel and sends
+//                                  `lines` PRIVMSGs; reports relayed lines
+//                                  per second until all are delivered
+//   fanout [clients] [channels] [rounds]
+//                                  everyone joins the same `channels`
+//                                  channels, changes nick `rounds` times,
+//                                  then all but one quit; checks that each
+//                                  change reaches each peer exactly once
+//   fair [members] [light] [pings]
+//                                  `light` clients PING in turn, first on
+//                                  a quiet server, then while one client
+//                                  floods a channel of `members` readers;
+//                                  reports the PING round trips
+//
+// Usage: load <port> <password> <scenario> [args...]
+
+namespace {
+constexpr std::size_t CLIENTS = 50;
+constexpr std::size_t LINES = 200;
+constexpr std::size_t FANOUT_CLIENTS = 100;
+constexpr std::size_t FANOUT_CHANNELS = 20;
+constexpr std::size_t FANOUT_ROUNDS = 5;
+constexpr std::size_t FAIR_MEMBERS = 40;
+constexpr std::size_t FAIR_LIGHT = 10;
+constexpr std::size_t FAIR_PINGS = 2000;
+constexpr std::size_t FLOOD_LINES = 2000; // per refill of the flooder
+constexpr int DEADLINE_MS = 30000;
+
+// One client connection: what is left to write and the lines read so far.
+class Conn final {
+  public:
+    explicit Conn(const int fd) : _fd(fd) {
+    }
+
+    Conn(const Conn &rhs) = delete;
+    Conn &operator=(const Conn &rhs) = delete;
+
+    Conn(Conn &&rhs) noexcept
+        : _fd(rhs._fd), _out(std::move(rhs._out)), _sent(rhs._sent),
+          _in(std::move(rhs._in)) {
+        rhs._fd = -1;
+    }
+
+    ~Conn() {
+        if (_fd >= 0) {
+            close(_fd);
+        }
+    }
+
+  public:
+    int fd() const noexcept {
+        return _fd;
+    }
+
+    bool pending() const noexcept {
+        return _sent < _out.size();
+    }
+
+    void queue(const std::string &lines) {
+        _out.append(lines);
+    }
+
+    // Writes what the socket takes without blocking.
+    bool write() noexcept {
+        while (pending()) {
+            const ssize_t sent = send(_fd, _out.data() + _sent,
+                                      _out.size() - _sent,
+                                      MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (0 > sent) {
+                return errno == EAGAIN || errno == EINTR;
+            }
+            _sent += static_cast<std::size_t>(sent);
+        }
+
+        _out.clear();
+        _sent = 0;
+        return true;
+    }
+
+    // Reads what is there and hands each complete line to `online`, without
+    // its CRLF. False once the server closed the connection.
+    template <typename OnLine> bool read(OnLine online) {
+        char buffer[1 << 16];
+        for (;;) {
+            const ssize_t got = recv(_fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+            if (got == 0) {
+                return false;
+            }
+            if (0 > got) {
+                return errno == EAGAIN || errno == EINTR;
+            }
+            _in.append(buffer, static_cast<std::size_t>(got));
+
+            std::size_t begin = 0;
+            std::size_t end = 0;
+            while ((end = _in.find("\r\n", begin)) != std::string::npos) {
+                online(_in.data() + begin, end - begin);
+                begin = end + 2;
+            }
+            _in.erase(0, begin);
+        }
+    }
+
+  private:
+    int _fd;
+    std::string _out;
+    std::size_t _sent{0};
+    std::string _in;
+};
+
+bool contains(const char *line, const std::size_t length,
+              const char *word) noexcept {
+    const std::size_t size = std::strlen(word);
+    for (std::size_t index = 0; index + size <= length; ++index) {
+        if (std::memcmp(line + index, word, size) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int connectTo(const std::uint16_t port) noexcept {
+    const int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (0 > fd) {
+        return -1;
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (0 > connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr))) {
+        close(fd);
+        return -1;
+    }
+
+    const int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+// Polls every connection until `done` says so or the deadline passes;
+// `online(index, line, length)` sees each line read. Returns false on a
+// timeout or a closed connection.
+template <typename OnLine, typename Done>
+bool pump(std::vector<Conn> &conns, OnLine online, Done done) {
+    const BenchClock::time_point start = BenchClock::now();
+    std::vector<pollfd> fds(conns.size());
+
+    while (done() != true) {
+        if (benchSeconds(start) * 1000 > DEADLINE_MS) {
+            std::fprintf(stderr, "load: timed out\n");
+            return false;
+        }
+
+        for (std::size_t index = 0; index < conns.size(); ++index) {
+            fds[index].fd = conns[index].fd();
+            fds[index].events = static_cast<short>(
+                POLLIN | (conns[index].pending() ? POLLOUT : 0));
+            fds[index].revents = 0;
+        }
+        if (0 > poll(fds.data(), fds.size(), 100)) {
+            continue;
+        }
+
+        for (std::size_t index = 0; index < conns.size(); ++index) {
+            Conn &conn = conns[index];
+            if ((fds[index].revents & POLLOUT) && conn.write() != true) {
+                std::fprintf(stderr, "load: send failed\n");
+                return false;
+            }
+            if ((fds[index].revents & (POLLIN | POLLHUP | POLLERR)) == 0) {
+                continue;
+            }
+
+            const bool open =
+                conn.read([&online, index](const char *line,
+                                           const std::size_t length) {
+                    online(index, line, length);
+                });
+            if (open != true) {
+                std::fprintf(stderr, "load: client %zu disconnected\n", index);
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Adds `count` clients named <prefix><index> and waits until each has
+// joined every channel in `channels`, separated by commas.
+bool connectAll(std::vector<Conn> &conns, const std::size_t count,
+                const std::uint16_t port, const std::string &password,
+                const std::string &prefix, const std::string &channels) {
+    std::size_t total = 1;
+    for (const char c : channels) {
+        total += c == ',' ? 1 : 0;
+    }
+
+    const std::size_t first = conns.size();
+    for (std::size_t index = 0; index < count; ++index) {
+        const int fd = connectTo(port);
+        if (0 > fd) {
+            std::fprintf(stderr, "load: connect: %s\n", std::strerror(errno));
+            return false;
+        }
+
+        conns.emplace_back(fd);
+        const std::string nick = prefix + std::to_string(index);
+        conns.back().queue("PASS " + password + "\r\nNICK " + nick +
+                           "\r\nUSER " + nick + " 0 * :" + nick +
+                           "\r\nJOIN " + channels + "\r\n");
+        conns.back().write();
+    }
+
+    // 366 ends the NAMES list each JOIN answers with.
+    std::size_t waiting = count * total;
+    return pump(
+        conns,
+        [first, &waiting](const std::size_t index, const char *line,
+                          const std::size_t length) {
+            if (index >= first && contains(line, length, " 366 ")) {
+                --waiting;
+            }
+        },
+        [&waiting]() { return waiting == 0; });
+}
+
+int throughput(const std::uint16_t port, const std::string &password,
+               const std::size_t clients, const std::size_t lines) {
+    std::vector<Conn> conns;
+    conns.reserve(clients);
+    if (connectAll(conns, clients, port, password, "t", "#bench") != true) {
+        return 1;
+    }
+
+    const std::size_t expected = clients * (clients - 1) * lines;
+    std::size_t delivered = 0;
+    const BenchClock::time_point start = BenchClock::now();
+    for (std::size_t index = 0; index < clients; ++index) {
+        std::string burst;
+        for (std::size_t line = 0; line < lines; ++line) {
+            burst += "PRIVMSG #bench :line " + std::to_string(line) +
+                     " of an ordinary burst of chatter\r\n";
+        }
+        conns[index].queue(burst);
+        conns[index].write();
+    }
+
+    const bool ok = pump(
+        conns,
+        [&delivered](std::size_t, const char *line, const std::size_t length) {
+            if (contains(line, length, " PRIVMSG #bench ")) {
+                ++delivered;
+            }
+        },
+        [&delivered, expected]() { return delivered >= expected; });
+
+    const double seconds = benchSeconds(start);
+    std::printf("  %zu clients x %zu lines: %zu of %zu relayed in %.3f s, "
+                "%.0f lines/s\n",
+                clients, lines, delivered, expected, seconds,
+                static_cast<double>(delivered) / seconds);
+    return ok ? 0 : 1;
+}
+int fanout(const std::uint16_t port, const std::string &password,
+           const std::size_t clients, const std::size_t channels,
+           const std::size_t rounds) {
+    std::string names;
+    for (std::size_t index = 0; index < channels; ++index) {
+        names += (index == 0 ? "#f" : ",#f") + std::to_string(index);
+    }
+
+    std::vector<Conn> conns;
+    conns.reserve(clients);
+    if (connectAll(conns, clients, port, password, "f", names) != true) {
+        return 1;
+    }
+
+    // Every client sees its own NICK once and each peer's once, however
+    // many channels they share.
+    std::vector<std::size_t> seen(clients, 0);
+    std::size_t delivered = 0;
+    const auto count = [&seen, &delivered](const std::size_t index,
+                                           const char *line,
+                                           const std::size_t length) {
+        if (contains(line, length, " NICK ")) {
+            ++seen[index];
+            ++delivered;
+        }
+    };
+
+    const BenchClock::time_point start = BenchClock::now();
+    for (std::size_t round = 0; round < rounds; ++round) {
+        for (std::size_t index = 0; index < clients; ++index) {
+            conns[index].queue("NICK f" + std::to_string(index) + "r" +
+                               std::to_string(round) + "\r\n");
+            conns[index].write();
+        }
+    }
+
+    const std::size_t expected = clients * clients * rounds;
+    bool ok = pump(conns, count,
+                   [&delivered, expected]() { return delivered >= expected; });
+    const double nickSeconds = benchSeconds(start);
+
+    std::size_t wrong = 0;
+    for (const std::size_t got : seen) {
+        wrong += got != clients * rounds ? 1 : 0;
+    }
+    std::printf("  %zu clients on %zu shared channels: %zu NICKs, %zu lines "
+                "in %.3f s, %.0f lines/s, %zu clients miscounted\n",
+                clients, channels, clients * rounds, delivered, nickSeconds,
+                static_cast<double>(delivered) / nickSeconds, wrong);
+
+    // The others hang up right after their QUIT; the one left sees each
+    // of them leave once.
+    for (std::size_t index = 1; index < clients; ++index) {
+        conns[index].queue("QUIT :done\r\n");
+        conns[index].write();
+    }
+    while (conns.size() > 1) {
+        conns.pop_back();
+    }
+
+    std::size_t quits = 0;
+    const auto countQuits = [&quits](std::size_t, const char *line,
+                                     const std::size_t length) {
+        if (contains(line, length, " QUIT ")) {
+            ++quits;
+        }
+    };
+
+    const BenchClock::time_point quitStart = BenchClock::now();
+    ok = pump(conns, countQuits,
+              [&quits, clients]() { return quits >= clients - 1; }) &&
+         ok;
+    const double quitSeconds = benchSeconds(quitStart);
+
+    // A duplicate would arrive right behind the last expected line.
+    const BenchClock::time_point grace = BenchClock::now();
+    pump(conns, countQuits, [&grace]() { return benchSeconds(grace) > 0.2; });
+
+    std::printf("  %zu QUITs: %zu lines for the last member in %.3f s\n",
+                clients - 1, quits, quitSeconds);
+    return ok && wrong == 0 && quits == clients - 1 ? 0 : 1;
+}
+// Round trips, in milliseconds, of `pings` PINGs from the light clients
+// at [first, conns.size()), each with one PING out at a time. With
+// `flooder` set, its queue is topped up with channel messages for as long
+// as they run; `relayed` counts what the other clients read of them.
+bool pingAll(std::vector<Conn> &conns, const std::size_t first,
+             const std::size_t pings, Conn *flooder, std::size_t &relayed,
+             std::vector<double> &rtts) {
+    std::string flood;
+    for (std::size_t line = 0; line < FLOOD_LINES; ++line) {
+        flood += "PRIVMSG #flood :" + std::string(60, 'y') + "\r\n";
+    }
+
+    std::vector<BenchClock::time_point> sentAt(conns.size());
+    std::size_t sent = 0;
+    const auto ping = [&conns, &sentAt, &sent](const std::size_t index) {
+        conns[index].queue("PING :t" + std::to_string(sent++) + "\r\n");
+        sentAt[index] = BenchClock::now();
+        conns[index].write();
+    };
+
+    for (std::size_t index = first; index < conns.size() && sent < pings;
+         ++index) {
+        ping(index);
+    }
+
+    return pump(
+        conns,
+        [&](const std::size_t index, const char *line,
+            const std::size_t length) {
+            if (index < first) {
+                if (contains(line, length, " PRIVMSG ")) {
+                    ++relayed;
+                }
+                return;
+            }
+            if (contains(line, length, " PONG ") != true) {
+                return;
+            }
+
+            rtts.push_back(benchSeconds(sentAt[index]) * 1000);
+            if (sent < pings) {
+                ping(index);
+            }
+        },
+        // Checked once per poll round, which is also when the flooder's
+        // queue is topped up.
+        [&]() {
+            if (flooder != nullptr && flooder->pending() != true) {
+                flooder->queue(flood);
+            }
+            return rtts.size() >= pings;
+        });
+}
+
+void printRtts(const char *name, std::vector<double> &rtts,
+               const std::size_t relayed, const double seconds) {
+    std::sort(rtts.begin(), rtts.end());
+    std::printf("  %-12s PING p50 %7.2f ms  p99 %7.2f ms  max %7.2f ms, "
+                "%.0f flood lines/s relayed\n",
+                name, rtts[rtts.size() / 2], rtts[rtts.size() * 99 / 100],
+                rtts.back(), static_cast<double>(relayed) / seconds);
+}
+
+int fair(const std::uint16_t port, const std::string &password,
+         const std::size_t members, const std::size_t light,
+         const std::size_t pings) {
+    // Members read #flood, then the flooder joins it; the light clients
+    // sit in a channel of their own.
+    std::vector<Conn> conns;
+    conns.reserve(members + 1 + light);
+    if (connectAll(conns, members, port, password, "m", "#flood") != true ||
+        connectAll(conns, 1, port, password, "flood", "#flood") != true ||
+        connectAll(conns, light, port, password, "l", "#light") != true) {
+        return 1;
+    }
+
+    const std::size_t first = members + 1;
+    for (const bool flooding : {false, true}) {
+        std::size_t relayed = 0;
+        std::vector<double> rtts;
+        const BenchClock::time_point start = BenchClock::now();
+        if (pingAll(conns, first, pings, flooding ? &conns[members] : nullptr,
+                    relayed, rtts) != true) {
+            return 1;
+        }
+
+        printRtts(flooding ? "1 flooding" : "quiet", rtts, relayed,
+                  benchSeconds(start));
+    }
+
+    return 0;
+}
+} // namespace
+
+int main(const int argc, char **argv) {
+    if (argc < 4) {
+        std::fprintf(stderr,
+                     "Usage: %s <port> <password> throughput|fanout|fair "
+                     "[args...]\n",
+                     argv[0]);
+        return 2;
+    }
+
+    const std::uint16_t port = static_cast<std::uint16_t>(
+        benchArg(argc, argv, 1, 6667) & 0xFFFF);
+    const std::string password = argv[2];
+    const std::string scenario = argv[3];
+
+    if (scenario == "throughput") {
+        return throughput(port, password, benchArg(argc, argv, 4, CLIENTS),
+                          benchArg(argc, argv, 5, LINES));
+    }
+    if (scenario == "fanout") {
+        return fanout(port, password, benchArg(argc, argv, 4, FANOUT_CLIENTS),
+                      benchArg(argc, argv, 5, FANOUT_CHANNELS),
+                      benchArg(argc, argv, 6, FANOUT_ROUNDS));
+    }
+    if (scenario == "fair") {
+        return fair(port, password, benchArg(argc, argv, 4, FAIR_MEMBERS),
+                    benchArg(argc, argv, 5, FAIR_LIGHT),
+                    benchArg(argc, argv, 6, FAIR_PINGS));
+    }
+
+    std::fprintf(stderr, "Unknown scenario: %s\n", scenario.c_str());
+    return 2;
+}
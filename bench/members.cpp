@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "../include/Client.hpp"
+#include "../include/MemberTable.hpp"
+#include "./Bench.hpp"
+
+// Channel membership: join, part and the walk a broadcast makes over every
+// member, on one channel of N members.
+//
+//   sets         the containers this replaced: unordered_sets of
+//                shared_ptr<Client> for users and operators, searched with
+//                std::find as Channel did before a join, on part and for
+//                every operator check
+//   MemberTable  the table Channel keeps now, driven the same way
+//
+// Only the membership bookkeeping is timed; formatting and queueing a
+// broadcast line is the same for both and left out.
+//
+// Usage: members [max members]
+
+namespace {
+constexpr std::size_t MEMBERS = 10000;
+constexpr std::size_t SIZES[] = {100, 1000, 10000};
+constexpr std::size_t WALK_RECIPIENTS = 10000000;
+
+using Users = std::unordered_set<std::shared_ptr<Client>>;
+
+struct Sets {
+    Users users;
+    Users operators;
+};
+
+void joinSets(Sets &channel, const std::shared_ptr<Client> &user) {
+    if (std::find(channel.users.begin(), channel.users.end(), user) !=
+        channel.users.end()) {
+        return;
+    }
+
+    channel.users.emplace(user);
+}
+
+void partSets(Sets &channel, const std::shared_ptr<Client> &user) {
+    if (std::find(channel.users.begin(), channel.users.end(), user) ==
+        channel.users.end()) {
+        return;
+    }
+
+    channel.users.erase(user);
+    if (std::find(channel.operators.begin(), channel.operators.end(),
+                  user) != channel.operators.end()) {
+        channel.operators.erase(user);
+    }
+}
+
+std::size_t walkSets(const Sets &channel) noexcept {
+    std::size_t sum = 0;
+    for (const std::shared_ptr<Client> &user : channel.users) {
+        sum += static_cast<std::size_t>(user->getFD());
+    }
+
+    return sum;
+}
+
+void joinTable(MemberTable &channel, Client *user) {
+    if (channel.has(user, MemberFlag::JOINED)) {
+        return;
+    }
+
+    channel.set(user, MemberFlag::JOINED);
+}
+
+void partTable(MemberTable &channel, Client *user) noexcept {
+    if (channel.has(user, MemberFlag::JOINED) != true) {
+        return;
+    }
+
+    channel.clear(user, MemberFlag::JOINED);
+    channel.clear(user, MemberFlag::OPERATOR);
+}
+
+std::size_t walkTable(const MemberTable &channel) noexcept {
+    std::size_t sum = 0;
+    for (const Member &member : channel) {
+        sum += static_cast<std::size_t>(member.client->getFD());
+    }
+
+    return sum;
+}
+
+void row(const std::size_t size, const char *operation, const char *kind,
+         const double seconds, const std::size_t ops) {
+    benchRow("N=" + std::to_string(size) + " " + operation + " " + kind,
+             seconds * 1e9 / static_cast<double>(ops));
+}
+
+// Joins everyone, walks the channel until WALK_RECIPIENTS members were
+// visited, then parts everyone in another order.
+void run(const std::vector<std::shared_ptr<Client>> &clients,
+         const std::vector<std::size_t> &partOrder) {
+    const std::size_t size = clients.size();
+    const std::size_t walks = std::max<std::size_t>(1, WALK_RECIPIENTS / size);
+
+    Sets sets;
+    BenchClock::time_point start = BenchClock::now();
+    for (const std::shared_ptr<Client> &client : clients) {
+        joinSets(sets, client);
+    }
+    const double setsJoin = benchSeconds(start);
+
+    start = BenchClock::now();
+    for (std::size_t walk = 0; walk < walks; ++walk) {
+        benchKeep(walkSets(sets));
+    }
+    const double setsWalk = benchSeconds(start);
+
+    start = BenchClock::now();
+    for (const std::size_t index : partOrder) {
+        partSets(sets, clients[index]);
+    }
+    const double setsPart = benchSeconds(start);
+
+    MemberTable table;
+    start = BenchClock::now();
+    for (const std::shared_ptr<Client> &client : clients) {
+        joinTable(table, client.get());
+    }
+    const double tableJoin = benchSeconds(start);
+
+    start = BenchClock::now();
+    for (std::size_t walk = 0; walk < walks; ++walk) {
+        benchKeep(walkTable(table));
+    }
+    const double tableWalk = benchSeconds(start);
+
+    start = BenchClock::now();
+    for (const std::size_t index : partOrder) {
+        partTable(table, clients[index].get());
+    }
+    const double tablePart = benchSeconds(start);
+
+    row(size, "join", "sets", setsJoin, size);
+    row(size, "join", "MemberTable", tableJoin, size);
+    row(size, "part", "sets", setsPart, size);
+    row(size, "part", "MemberTable", tablePart, size);
+    row(size, "broadcast/member", "sets", setsWalk, walks * size);
+    row(size, "broadcast/member", "MemberTable", tableWalk, walks * size);
+}
+} // namespace
+
+int main(const int argc, char **argv) {
+    const std::size_t most = benchArg(argc, argv, 1, MEMBERS);
+
+    // The clients only stand in for their address; fd -1 is never closed.
+    std::vector<std::shared_ptr<Client>> clients;
+    clients.reserve(most);
+    for (std::size_t index = 0; index < most; ++index) {
+        clients.push_back(std::make_shared<Client>(-1));
+    }
+
+    benchTitle("members: one channel of N, old sets vs MemberTable");
+    std::mt19937 random(42);
+    for (const std::size_t size : SIZES) {
+        if (size > most) {
+            break;
+        }
+
+        const std::vector<std::shared_ptr<Client>> members(
+            clients.begin(),
+            clients.begin() + static_cast<std::ptrdiff_t>(size));
+        std::vector<std::size_t> partOrder(size);
+        for (std::size_t index = 0; index < size; ++index) {
+            partOrder[index] = index;
+        }
+        std::shuffle(partOrder.begin(), partOrder.end(), random);
+        run(members, partOrder);
+    }
+
+    return 0;
+}
@@ -0,0 +1,224 @@
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "../include/Client.hpp"
+#include "../include/Config.hpp"
+#include "../include/EpollBackend.hpp"
+#include "./Bench.hpp"
+
+// Output path: how many syscalls and how much time it takes to deliver a
+// burst of lines queued for one client, over a socketpair drained by
+// another thread.
+//
+//   string queue  the queue this replaced: a std::queue<std::string>, a
+//                 line copied out and sent with one send() each, and an
+//                 epoll_ctl(MOD) per appended line to ask for EPOLLOUT.
+//   sendmsg       Client::appendMessageToQue and EpollBackend::flush as they
+//                 are: chunked OutputBuffer, one sendmsg() per 256 segments
+//                 and no syscall to mark the client.
+//
+// Usage: output [lines]
+
+namespace {
+constexpr std::size_t LINES = 200000;
+constexpr std::size_t BURSTS[] = {1, 8, 64, 512};
+
+std::atomic<std::size_t> g_syscalls{0};
+
+std::string makeLine(const std::size_t index) {
+    return ":nick" + std::to_string(index % 100) +
+           "!user@127.0.0.1 PRIVMSG #bench :a line of ordinary chatter " +
+           std::to_string(index) + "\r\n";
+}
+
+// Blocks until the socket can take more, the way the server would wait for
+// EPOLLOUT.
+void waitWritable(const int fd) {
+    pollfd entry{fd, POLLOUT, 0};
+    ++g_syscalls;
+    poll(&entry, 1, -1);
+}
+
+struct Result {
+    double seconds;
+    std::size_t syscalls;
+};
+
+class Pair final {
+  public:
+    Pair() {
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, _fds) != 0) {
+            std::perror("socketpair");
+            std::exit(1);
+        }
+    }
+
+    Pair(const Pair &rhs) = delete;
+    Pair &operator=(const Pair &rhs) = delete;
+
+    ~Pair() {
+        if (_reader.joinable()) {
+            _reader.join();
+        }
+        close(_fds[1]);
+    }
+
+  public:
+    // The sending end; whoever holds it closes it.
+    int sender() const noexcept {
+        return _fds[0];
+    }
+
+    void drain(const std::size_t bytes) {
+        const int fd = _fds[1];
+        _reader = std::thread([fd, bytes]() {
+            std::vector<char> buffer(1 << 18);
+            std::size_t total = 0;
+            while (total < bytes) {
+                const ssize_t got = recv(fd, buffer.data(), buffer.size(), 0);
+                if (got <= 0) {
+                    return;
+                }
+                total += static_cast<std::size_t>(got);
+            }
+        });
+    }
+
+  private:
+    int _fds[2];
+    std::thread _reader;
+};
+
+Result runQueue(const std::vector<std::string> &lines,
+                const std::size_t burst) {
+    std::size_t bytes = 0;
+    for (const std::string &line : lines) {
+        bytes += line.size();
+    }
+
+    Pair pair;
+    const int fd = pair.sender();
+    const int epoll = epoll_create1(0);
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &ev);
+    pair.drain(bytes);
+
+    g_syscalls = 0;
+    const BenchClock::time_point start = BenchClock::now();
+    std::queue<std::string> messages;
+    std::size_t offset = 0;
+    for (std::size_t next = 0; next < lines.size();) {
+        for (std::size_t count = 0; count < burst && next < lines.size();
+             ++count, ++next) {
+            messages.emplace(lines[next]);
+            ev.events = EPOLLIN | EPOLLOUT;
+            ++g_syscalls;
+            epoll_ctl(epoll, EPOLL_CTL_MOD, fd, &ev);
+        }
+
+        while (messages.empty() != true) {
+            const std::string msg = messages.front();
+            ++g_syscalls;
+            const ssize_t sent =
+                send(fd, msg.c_str() + offset, msg.length() - offset,
+                     MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (0 > sent) {
+                waitWritable(fd);
+                continue;
+            }
+
+            offset += static_cast<std::size_t>(sent);
+            if (offset >= msg.length()) {
+                messages.pop();
+                offset = 0;
+            }
+        }
+        ev.events = EPOLLIN;
+        ++g_syscalls;
+        epoll_ctl(epoll, EPOLL_CTL_MOD, fd, &ev);
+    }
+
+    const Result result{benchSeconds(start), g_syscalls.load()};
+    close(epoll);
+    close(fd);
+    return result;
+}
+
+Result runChunked(const std::vector<std::string> &lines,
+                  const std::size_t burst) {
+    std::size_t bytes = 0;
+    for (const std::string &line : lines) {
+        bytes += line.size();
+    }
+
+    Pair pair;
+    pair.drain(bytes);
+    EpollBackend backend{Config()};
+    Client client(pair.sender()); // closes the sender
+
+    g_syscalls = 0;
+    const BenchClock::time_point start = BenchClock::now();
+    for (std::size_t next = 0; next < lines.size();) {
+        for (std::size_t count = 0; count < burst && next < lines.size();
+             ++count, ++next) {
+            client.appendMessageToQue(lines[next]);
+        }
+
+        while (backend.flush(client) == FlushResult::PENDING) {
+            waitWritable(client.getFD());
+        }
+    }
+
+    return Result{benchSeconds(start), g_syscalls.load()};
+}
+} // namespace
+
+// EpollBackend::flush calls this instead of the C library's, so its
+// syscalls are counted without changing the code under test.
+extern "C" ssize_t sendmsg(const int fd, const msghdr *msg, const int flags) {
+    ++g_syscalls;
+    return syscall(SYS_sendmsg, fd, msg, flags);
+}
+
+int main(const int argc, char **argv) {
+    const std::size_t count = benchArg(argc, argv, 1, LINES);
+    std::vector<std::string> lines;
+    lines.reserve(count);
+    for (std::size_t index = 0; index < count; ++index) {
+        lines.push_back(makeLine(index));
+    }
+
+    benchTitle("output: lines per flush, string queue vs chunked sendmsg");
+    for (const std::size_t burst : BURSTS) {
+        const Result queue = runQueue(lines, burst);
+        const Result chunked = runChunked(lines, burst);
+        const double n = static_cast<double>(count);
+
+        char extra[96];
+        std::snprintf(extra, sizeof(extra), "%6.3f syscalls/line",
+                      static_cast<double>(queue.syscalls) / n);
+        benchRow("burst " + std::to_string(burst) + " string queue",
+                 queue.seconds * 1e9 / n, extra);
+        std::snprintf(extra, sizeof(extra), "%6.3f syscalls/line",
+                      static_cast<double>(chunked.syscalls) / n);
+        benchRow("burst " + std::to_string(burst) + " sendmsg",
+                 chunked.seconds * 1e9 / n, extra);
+    }
+
+    return 0;
+}
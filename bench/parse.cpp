@@ -0,0 +1,208 @@
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../include/Enums.hpp"
+#include "../include/Token.hpp"
+#include "../include/Utils.hpp"
+#include "./Bench.hpp"
+
+// Parser: ns and heap allocations per line on a PRIVMSG / JOIN / MODE mix.
+//
+//   istringstream    the parser this replaced, kept below as it was for the
+//                    commands in the mix: split on CRLF, one stream per
+//                    line, a string per word
+//   parseMessage     views into the line, as the server frames it
+//   parseIRCMessage  parseMessage plus the owning, validated IRCMessage the
+//                    dispatch phase gets
+//
+// Usage: parse [rounds]
+
+namespace {
+constexpr std::size_t ROUNDS = 20000;
+
+std::size_t g_allocations = 0;
+
+const char *const MIX[] = {
+    "PRIVMSG #general :hey, anyone around to look at the build?",
+    "PRIVMSG #general :it fails on the new runner, log is in the ticket",
+    "PRIVMSG alice :can you have a look at #ops when you have a minute",
+    "PRIVMSG #ops :deploy of 4.2.1 is done, watching the error rate",
+    "PRIVMSG #random :lunch?",
+    "PRIVMSG #general,#ops :heads up: maintenance at 18:00 UTC",
+    "PRIVMSG bob :thanks!",
+    "JOIN #general",
+    "JOIN #ops,#random key1",
+    "MODE #ops +o alice",
+    "MODE #general +l 50",
+    "MODE #random",
+};
+
+// The old parser, cut down to the commands in MIX.
+IRCCommand legacyCommand(const std::string &command) {
+    static const std::unordered_map<std::string, IRCCommand> commandMap = {
+        {"CAP", IRCCommand::CAP},         {"NICK", IRCCommand::NICK},
+        {"USER", IRCCommand::USER},       {"PASS", IRCCommand::PASS},
+        {"PRIVMSG", IRCCommand::PRIVMSG}, {"JOIN", IRCCommand::JOIN},
+        {"TOPIC", IRCCommand::TOPIC},     {"PART", IRCCommand::PART},
+        {"QUIT", IRCCommand::QUIT},       {"PING", IRCCommand::PING},
+        {"KICK", IRCCommand::KICK},       {"INVITE", IRCCommand::INVITE},
+        {"MODE", IRCCommand::MODE},       {"USERHOST", IRCCommand::USERHOST},
+        {"UNKNOW", IRCCommand::UNKNOW},   {"WHOIS", IRCCommand::WHOIS}};
+
+    const auto it = commandMap.find(command);
+    if (it == commandMap.end()) {
+        return IRCCommand::UNKNOW;
+    }
+
+    return it->second;
+}
+
+void legacyJoin(IRCMessage &token) {
+    if (token.params.size() > 1) {
+        const std::vector<std::string> keys = split(token.params[1], ",");
+        for (const std::string &key : keys) {
+            token.keys.emplace_back(key);
+        }
+    }
+
+    const std::vector<std::string> channels = split(token.params[0], ",");
+    token.params.clear();
+    for (const std::string &channel : channels) {
+        token.params.emplace_back(channel);
+    }
+}
+
+void legacyMode(IRCMessage &token) {
+    if (token.params.size() == 1) {
+        return;
+    }
+
+    const std::string allowedModes = "itkol";
+    const std::string firstAllowed = "+-";
+    if (firstAllowed.find(token.params[1][0]) == std::string::npos ||
+        allowedModes.find(token.params[1][1]) == std::string::npos) {
+        token.err.set_value(IRCCode::UNKNOWMODE);
+        token.errMsg = "MODE " + token.params[1];
+        token.succes = false;
+    }
+}
+
+std::vector<IRCMessage> legacyParse(const std::string &msg) {
+    std::vector<IRCMessage> tokens;
+    std::string word;
+    const std::vector<std::string> lines = split(msg, "\r\n");
+
+    for (const std::string &line : lines) {
+        IRCMessage parsed = {};
+        std::istringstream stream(line);
+
+        if (line[0] == ':') {
+            stream >> parsed.prefix;
+            parsed.prefix.erase(0, 1);
+        }
+
+        if (stream >> parsed.command) {
+            while (stream >> word) {
+                if (word[0] == ':') {
+                    std::string rest;
+                    std::getline(stream, rest);
+                    parsed.params.emplace_back(word.substr(1) + rest);
+                    break;
+                }
+
+                parsed.params.emplace_back(word);
+            }
+        }
+
+        parsed.succes = true;
+        parsed.type = legacyCommand(parsed.command);
+        parsed.errMsg = "";
+        if (parsed.command != "") {
+            tokens.emplace_back(parsed);
+        }
+    }
+
+    for (IRCMessage &token : tokens) {
+        if (token.type == IRCCommand::JOIN) {
+            legacyJoin(token);
+        } else if (token.type == IRCCommand::MODE) {
+            legacyMode(token);
+        }
+    }
+
+    return tokens;
+}
+
+template <typename Parse>
+void measure(const char *name, const std::size_t rounds, Parse parse) {
+    const std::size_t lines = rounds * (sizeof(MIX) / sizeof(MIX[0]));
+    const std::size_t allocations = g_allocations;
+    const BenchClock::time_point start = BenchClock::now();
+
+    for (std::size_t round = 0; round < rounds; ++round) {
+        for (std::size_t index = 0; index < sizeof(MIX) / sizeof(MIX[0]);
+             ++index) {
+            benchKeep(parse(index));
+        }
+    }
+
+    const double seconds = benchSeconds(start);
+    char extra[64];
+    std::snprintf(extra, sizeof(extra), "%6.2f allocs/line",
+                  static_cast<double>(g_allocations - allocations) /
+                      static_cast<double>(lines));
+    benchRow(name, seconds * 1e9 / static_cast<double>(lines), extra);
+}
+} // namespace
+
+// Counts every heap allocation made by the program.
+void *operator new(const std::size_t size) {
+    ++g_allocations;
+    void *block = std::malloc(size == 0 ? 1 : size);
+    if (block == nullptr) {
+        throw std::bad_alloc();
+    }
+    return block;
+}
+
+void operator delete(void *block) noexcept {
+    std::free(block);
+}
+
+void operator delete(void *block, std::size_t) noexcept {
+    std::free(block);
+}
+
+int main(const int argc, char **argv) {
+    const std::size_t rounds = benchArg(argc, argv, 1, ROUNDS);
+
+    std::vector<std::string> framed;
+    std::vector<std::string> lines;
+    for (const char *line : MIX) {
+        lines.emplace_back(line);
+        framed.emplace_back(std::string(line) + "\r\n");
+    }
+
+    benchTitle("parse: PRIVMSG / JOIN / MODE mix");
+    measure("istringstream", rounds, [&framed](const std::size_t index) {
+        return legacyParse(framed[index]).size();
+    });
+    measure("parseMessage", rounds, [&lines](const std::size_t index) {
+        MessageView view;
+        parseMessage(lines[index].data(), lines[index].size(), view);
+        return view.paramCount;
+    });
+    measure("parseIRCMessage", rounds, [&lines](const std::size_t index) {
+        IRCMessage token = {};
+        parseIRCMessage(lines[index].data(), lines[index].size(), token);
+        return token.params.size();
+    });
+
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+#include "../include/Client.hpp"
+#include "../include/Enums.hpp"
+#include "../include/Utils.hpp"
+#include "./Bench.hpp"
+
+// Numeric replies: how many a second one client's queue takes, drained
+// every 64 lines as a flush would.
+//
+//   ostringstream  the switch this replaced, for the codes below: the
+//                  numeric re-padded with std::to_string, the line built
+//                  with formatMessage and appended as a string
+//   catalog        handleMsg as it is: the compiled ReplyCatalog entry
+//                  written straight into the OutputBuffer
+//
+// Usage: replies [replies]
+
+namespace {
+constexpr std::size_t REPLIES = 2000000;
+constexpr std::size_t DRAIN_EVERY = 64;
+
+struct Case {
+    IRCCode code;
+    const char *name;
+};
+
+const Case CASES[] = {{IRCCode::NOSUCHNICK, "NOSUCHNICK"},
+                      {IRCCode::NAMREPLY, "NAMREPLY"},
+                      {IRCCode::WELCOME, "WELCOME"}};
+
+// The old handleMsg, cut down to CASES.
+void legacyReply(const IRCCode code, Client *client, const std::string &value,
+                 const std::string &msg) {
+    std::string ircCode = std::to_string(static_cast<std::uint16_t>(code));
+    if (ircCode.length() < 3) {
+        ircCode.insert(0, 3 - ircCode.length(), '0');
+    }
+
+    if (code == IRCCode::WELCOME) {
+        client->appendMessageToQue(formatMessage(
+            ":", serverName, " ", ircCode, " ", client->getNickname(),
+            " :Welcome to the IRCCodam Network ", client->getFullID()));
+    } else if (code == IRCCode::NAMREPLY) {
+        client->appendMessageToQue(
+            formatMessage(":", serverName, " ", ircCode, " ",
+                          client->getNickname(), " = ", value, " :", msg));
+    } else {
+        client->appendMessageToQue(formatMessage(
+            ":", serverName, " ", ircCode, " ", client->getNickname(), " ",
+            value, " :No such nick/channel"));
+    }
+}
+
+void drain(Client &client) noexcept {
+    const std::lock_guard<std::mutex> lock(client.getSendMutex());
+    client.getOutput().clear();
+}
+
+template <typename Reply>
+double measure(Client &client, const std::size_t replies, Reply reply) {
+    const BenchClock::time_point start = BenchClock::now();
+    for (std::size_t index = 0; index < replies; ++index) {
+        reply();
+        if (index % DRAIN_EVERY == DRAIN_EVERY - 1) {
+            drain(client);
+        }
+    }
+    drain(client);
+
+    return benchSeconds(start);
+}
+
+void row(const char *name, const char *kind, const double seconds,
+         const std::size_t replies) {
+    const double n = static_cast<double>(replies);
+    char extra[64];
+    std::snprintf(extra, sizeof(extra), "%6.2fM replies/s", n / seconds / 1e6);
+    benchRow(std::string(name) + " " + kind, seconds * 1e9 / n, extra);
+}
+} // namespace
+
+int main(const int argc, char **argv) {
+    const std::size_t replies = benchArg(argc, argv, 1, REPLIES);
+
+    Client client(-1); // fd -1 is never closed
+    client.setNickname("alice");
+    client.setUsername("alice");
+    client.setIP("127.0.0.1");
+
+    const std::string channel = "#general";
+    const std::string names = "@alice bob carol dave erin frank grace heidi";
+
+    benchTitle("replies: switch + ostringstream vs ReplyCatalog");
+    for (const Case &reply : CASES) {
+        const double legacy = measure(client, replies, [&]() {
+            legacyReply(reply.code, &client, channel, names);
+        });
+        const double catalog = measure(client, replies, [&]() {
+            handleMsg(reply.code, &client, channel, names);
+        });
+
+        row(reply.name, "ostringstream", legacy, replies);
+        row(reply.name, "catalog", catalog, replies);
+    }
+
+    return 0;
+}
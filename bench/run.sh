@@ -0,0 +1,65 @@
+#!/bin/bash
+
+# Usage: ./bench/run.sh [port]
+# Runs the microbenchmarks, then starts ./ircserv with flood control off and
+# drives it with bench/load on the epoll and the io_uring backend. `make
+# bench` builds everything and runs this.
+
+cd "$(dirname "$0")/.." || exit 1
+
+PORT="${1:-6690}"
+PASSWORD="bench"
+BIN="obj/bench"
+SERVER_PID=""
+STATUS=0
+
+# Extra IRC_* settings for one server run are passed as arguments, e.g.
+# start_server IRC_THREADS=4
+start_server() {
+    env IRC_FLOOD_RATE=0 IRC_UNREGISTERED_FLOOD_RATE=0 IRC_LOG_LEVEL=error \
+        "$@" ./ircserv "$PORT" "$PASSWORD" > /dev/null &
+    SERVER_PID=$!
+    sleep 0.5
+}
+
+stop_server() {
+    [ -n "$SERVER_PID" ] || return 0
+    kill -INT "$SERVER_PID" 2> /dev/null
+    wait "$SERVER_PID" 2> /dev/null
+    SERVER_PID=""
+}
+
+trap stop_server EXIT
+
+### Microbenchmarks
+
+"$BIN/members" || STATUS=1
+"$BIN/output" || STATUS=1
+"$BIN/parse" || STATUS=1
+"$BIN/replies" || STATUS=1
+
+### Against a running server
+
+# Runs one load scenario on a fresh server for each backend and thread
+# count, so epoll and io_uring can be compared row by row.
+run_load() {
+    echo
+    echo "== load: $1"
+    shift
+    for backend in epoll io_uring; do
+        for threads in 1 4; do
+            echo "$backend threads=$threads"
+            start_server IRC_BACKEND=$backend IRC_THREADS=$threads
+            "$BIN/load" "$PORT" "$PASSWORD" "$@" || STATUS=1
+            stop_server
+        done
+    done
+}
+
+run_load "one channel, everyone talking" throughput 50 200
+run_load "NICK and QUIT fan-out, 20 channels shared by everyone" \
+    fanout 100 20 5
+run_load "light clients' PING round trips next to a flooder" \
+    fair 40 10 2000
+
+exit $STATUS
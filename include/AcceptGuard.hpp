@@ -0,0 +1,44 @@
+#ifndef ACCEPTGUARD_HPP
+#define ACCEPTGUARD_HPP
+
+#include <atomic>
+#include <cstdint>
+
+#include "./EpollInterface.hpp"
+#include "./FileDescriptor.hpp"
+
+// Accept bookkeeping shared by the backends: counters that other threads may
+// read, and a descriptor held in reserve for when the process runs out. On
+// EMFILE/ENFILE the spare is released just long enough to accept the pending
+// connection and close it, so the listener stops reporting readable instead
+// of spinning on a connection it can never take.
+class AcceptGuard final {
+  public:
+    AcceptGuard();
+
+    AcceptGuard(const AcceptGuard &rhs) = delete;
+    AcceptGuard &operator=(const AcceptGuard &rhs) = delete;
+
+    AcceptGuard(AcceptGuard &&rhs) = delete;
+    AcceptGuard &operator=(AcceptGuard &&rhs) = delete;
+
+    ~AcceptGuard() = default;
+
+  public:
+    bool reserve() noexcept;
+    // Drops one pending connection; false if there was none to drop.
+    bool shed(int listenFD) noexcept;
+
+  public:
+    void accepted() noexcept;
+    void failed() noexcept;
+    void fillStats(IOStats &stats) const noexcept;
+
+  private:
+    FileDescriptor _spare;
+    std::atomic<std::uint64_t> _accepted{0};
+    std::atomic<std::uint64_t> _failed{0};
+    std::atomic<std::uint64_t> _shed{0};
+};
+
+#endif // !ACCEPTGUARD_HPP
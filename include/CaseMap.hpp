@@ -0,0 +1,27 @@
+#ifndef CASEMAP_HPP
+#define CASEMAP_HPP
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+
+// rfc1459 case mapping: besides ASCII letters, {}|~ are the lower case of
+// []\^, so "Nick[a]" and "nick{A}" name the same user.
+char ircFold(char c) noexcept;
+bool ircEquals(const std::string &lhs, const std::string &rhs) noexcept;
+
+struct CaseFoldHash {
+    std::size_t operator()(const std::string &key) const noexcept;
+};
+
+struct CaseFoldEqual {
+    bool operator()(const std::string &lhs,
+                    const std::string &rhs) const noexcept;
+};
+
+// Keeps each name as it was given, but hashes and compares it folded, so a
+// lookup takes the name as typed and never builds a folded copy.
+template <typename T>
+using CaseMap = std::unordered_map<std::string, T, CaseFoldHash, CaseFoldEqual>;
+
+#endif // !CASEMAP_HPP
@@ -2,17 +2,19 @@
 #define CHANNEL_HPP
 
 #include <bitset>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
-#include <unordered_set>
 
 #include "../include/Client.hpp"
 #include "../include/Enums.hpp"
+#include "../include/MemberTable.hpp"
 
 class Channel {
   public:
-    explicit Channel(std::string name, std::string topic,
-                     const std::shared_ptr<Client> &client);
+    explicit Channel(std::string name, std::string topic, Client *client);
 
     Channel(const Channel &) = delete;
     Channel &operator=(const Channel &) = delete;
@@ -20,31 +22,35 @@ class Channel {
     Channel(Channel &&rhs) noexcept;
     Channel &operator=(Channel &&rhs) noexcept;
 
-    ~Channel() = default;
+    ~Channel();
 
   public:
-    bool addUser(const std::string &password,
-                 const std::shared_ptr<Client> &user);
-    void removeUser(const std::shared_ptr<Client> &user,
-                    const std::string &reason);
-    void kickUser(const std::shared_ptr<Client> &target,
-                  const std::shared_ptr<Client> &client,
+    // Channels come and go with their members; freed blocks are kept for the
+    // next channel instead of going back to the heap.
+    static void *operator new(std::size_t size);
+    static void operator delete(void *block, std::size_t size) noexcept;
+
+  public:
+    bool addUser(const std::string &password, Client *user);
+    void removeUser(Client *user, const std::string &reason);
+    // Leaves without a PART: the caller already told the members.
+    void quitUser(Client *user);
+    void kickUser(Client *target, Client *client,
                   const std::string &reason);
-    void inviteUser(const std::shared_ptr<Client> &user,
-                    const std::shared_ptr<Client> &client);
+    // The invite's serial for expireInvite(), 0 if none was made.
+    std::uint16_t inviteUser(Client *user, Client *client);
 
   public:
     void setMode(ChannelMode mode, bool state, const std::string &value,
-                 const std::shared_ptr<Client> &client);
-    void setPassword(const std::string &password,
-                     const std::shared_ptr<Client> &client);
-    void setUserLimit(std::size_t limit, const std::shared_ptr<Client> &client);
-    void setTopic(const std::string &topic,
-                  const std::shared_ptr<Client> &client);
+                 Client *client);
+    void setPassword(const std::string &password, Client *client);
+    void setUserLimit(std::size_t limit, Client *client);
+    void setOperator(bool state, Client *target, Client *client);
+    void setTopic(const std::string &topic, Client *client);
 
   public:
-    void addOperator(const std::shared_ptr<Client> &user);
-    void removeOperator(const std::shared_ptr<Client> &user);
+    void addOperator(Client *user);
+    void removeOperator(Client *user);
 
   public:
     const std::string &getName() const noexcept;
@@ -52,20 +58,34 @@ class Channel {
     std::size_t getActiveUsers() const noexcept;
     std::string getChannelModes() const noexcept;
     std::string getChannelModesValues() const noexcept;
-    bool userOnChannel(const std::shared_ptr<Client> &user) const noexcept;
+    bool userOnChannel(Client *user) const noexcept;
+    const MemberTable &getMembers() const noexcept;
 
   public:
+    // `except`, when given, is left out: the sender of a PRIVMSG.
     void broadcast(IRCCode code, const std::string &senderPrefix,
-                   const std::string &message) const;
+                   const std::string &message,
+                   const Client *except = nullptr) const;
     std::string getUserList() const noexcept;
 
   public:
-    bool isOperator(const std::shared_ptr<Client> &user) const noexcept;
+    bool isOperator(Client *user) const noexcept;
 
   public:
     bool hasInvite() const noexcept;
-    bool isInvited(const std::shared_ptr<Client> &user) const noexcept;
-    void removeFromInvited(const std::shared_ptr<Client> &user) noexcept;
+    bool isInvited(Client *user) const noexcept;
+    void removeFromInvited(Client *user) noexcept;
+    // Lapses the invite of `user`'s connection `generation` if it is still
+    // the one inviteUser() gave `serial`.
+    bool expireInvite(Client *user, std::uint32_t generation,
+                      std::uint16_t serial) noexcept;
+
+  public:
+    // t, k or l: kept a while once empty so they survive a rejoin. +i is
+    // not, see quitUser.
+    bool hasPersistentModes() const noexcept;
+    void setEmptiedAt(std::chrono::steady_clock::time_point when) noexcept;
+    std::chrono::steady_clock::time_point getEmptiedAt() const noexcept;
 
   private:
     bool _hasPassword() const noexcept;
@@ -74,7 +94,10 @@ class Channel {
     bool _hasTopic() const noexcept;
 
   private:
-    bool _addUser(const std::shared_ptr<Client> &user);
+    bool _addUser(Client *user);
+    void _unlink(Client *user) noexcept;
+    void _unlinkAll() noexcept;
+    void _relinkAll() noexcept;
 
   private:
     std::string _name;
@@ -82,11 +105,10 @@ class Channel {
     std::string _password;
     std::size_t _userLimit;
     std::bitset<5> _modes; // invite, topic, password, operator, userlimit
+    std::chrono::steady_clock::time_point _emptiedAt;
 
   private:
-    std::unordered_set<std::shared_ptr<Client>> _users;
-    std::unordered_set<std::shared_ptr<Client>> _operators;
-    std::vector<std::shared_ptr<Client>> _invites;
+    MemberTable _members;
 };
 
 #endif // CHANNEL_HPP
@@ -9,11 +9,12 @@
 #include "./Server.hpp"
 
 std::string handleBot(const std::vector<std::string> &params,
-                      const std::shared_ptr<Client> &client, Server *server);
+                      Client *client, Server *server);
 bool isBot(const std::string &nickname);
-void botResponseNl(const std::shared_ptr<Client> &client,
+void botResponseNl(Client *client,
                    const std::string &response);
-bool handleSendApi(ApiRequest &api, epoll_event event, int epoll_fd);
-void handleRecvApi(ApiRequest &api);
+bool handleSendApi(ApiRequest &api, Client *client, epoll_event event,
+                   int epoll_fd);
+void handleRecvApi(ApiRequest &api, Client *client);
 
 #endif // !CHATBOT_HPP
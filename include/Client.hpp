@@ -1,19 +1,49 @@
 #ifndef CLIENT_HPP
 #define CLIENT_HPP
 
-#include <bitset>
-#include <queue>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
-#include <sys/epoll.h>
-
+#include "./Config.hpp"
 #include "./EpollInterface.hpp"
 #include "./FileDescriptor.hpp"
+#include "./Interned.hpp"
+#include "./LineBuffer.hpp"
+#include "./OutputBuffer.hpp"
+
+class Channel;
+
+// What the owning reactor does about a client's SendQ after a flush; see
+// Client::checkSendQ.
+enum class SendQAction : std::uint8_t { NONE, DROP, PAUSE, RESUME, EVICT };
+
+// What the owning reactor does about a client at its idle check; see
+// Client::checkIdle.
+enum class IdleAction : std::uint8_t { NONE, PING, TIMEOUT };
+
+struct SendQStats {
+    std::size_t queued; // queued plus in flight
+    std::size_t peak;
+    std::size_t limit; // 0 for none
+    std::uint32_t dropped; // lines refused
+};
 
+// Sized for hundreds of thousands of mostly idle connections per process.
+// An idle registered client that joined nothing costs sizeof(Client) in its
+// ClientSlab slot (budget: 256 bytes, checked in Client.cpp), its cached
+// nick!user@ip and the share of its interned nick; user, host and realname
+// are usually shared with other clients. Nothing else stays allocated: the
+// input tail and output chunks are freed once drained, and the channel list
+// is created on the first JOIN. Target: under 512 bytes of user space per
+// idle client, so 500k of them fit in about 256 MB besides the kernel's
+// socket buffers.
 class Client {
   public:
-    explicit Client(int fd);
+    explicit Client(int fd, std::uint32_t generation = 0);
 
     Client(const Client &rhs) = delete;
     Client &operator=(const Client &rhs) = delete;
@@ -25,10 +55,14 @@ class Client {
 
   public:
     void setEpollNotifier(EpollInterface *notifier);
+    void setReactor(std::size_t reactor) noexcept;
+    std::size_t getReactor() const noexcept;
+    std::mutex &getSendMutex() noexcept;
 
   public:
     int getFD() const noexcept;
-    epoll_event &getEvent() noexcept;
+    ClientHandle getHandle() const noexcept;
+    FileDescriptor takeFD() noexcept; // for ClientSlab::destroy
     bool isRegistered() const noexcept;
 
   public:
@@ -46,57 +80,150 @@ class Client {
     bool getUsernameBit() const noexcept;
     bool getNicknameBit() const noexcept;
     bool getPasswordBit() const noexcept;
-    std::string getFullID() const noexcept;
+    const std::string &getFullID() const noexcept; // nick!user@ip
 
   public:
     void setIP(const std::string &ip) noexcept;
     const std::string &getIP() const noexcept;
 
   public:
-    void appendToBuffer(const std::string &data) noexcept;
-    std::string getAndClearBuffer() noexcept;
-    bool hasCompleteMessage() const noexcept;
+    LineBuffer &getInput() noexcept;
 
   public:
-    std::string getMessage() noexcept;
-    void removeMessage() noexcept;
+    OutputBuffer &getOutput() noexcept; // hold getSendMutex()
     bool haveMessagesToSend() const noexcept;
     void appendMessageToQue(const std::string &msg) noexcept;
+    void appendPayload(const Payload &payload) noexcept;
+    // Runs writer(getOutput()) under the send mutex, for a line appended
+    // in pieces.
+    template <typename Writer>
+    void appendWith(Writer &&writer) noexcept;
     void setDisconnect() noexcept;
     bool isDisconnect() const noexcept;
 
   public:
-    void addChannel(const std::string &channelName) noexcept;
-    void removeChannel(const std::string &channelName) noexcept;
-    void removeAllChannels() noexcept;
-    const std::vector<std::string> &allChannels() const noexcept;
+    // The limits of the client's connection class; resets its flood
+    // budget. Owning reactor only.
+    void setConnectionClass(const ConnectionClass *limits,
+                            std::uint32_t now) noexcept;
 
   public:
-    void setOffset(std::size_t offset) noexcept;
-    std::size_t getOffset() const noexcept;
+    // The SendQ counts what is queued plus what a backend took but has not
+    // sent yet. An append past the class's limit is refused and flagged;
+    // the owning reactor picks that up through checkSendQ() after its next
+    // flush and applies the class's policy.
+    void setInFlight(std::size_t bytes) noexcept; // hold getSendMutex()
+    SendQAction checkSendQ() noexcept;
+    SendQStats getSendQStats() noexcept;
 
-  private:
-    EpollInterface *_epollNotifier{};
+  public:
+    // Flood control, on the owning reactor: a token bucket refilled from
+    // the class's rate at `now` (milliseconds, any fixed origin). A cost
+    // above the class's burst is charged as the burst.
+    bool spendTokens(std::size_t cost, std::uint32_t now) noexcept;
+    std::uint32_t tokenDelay(std::size_t cost,
+                             std::uint32_t now) const noexcept;
+
+  public:
+    // Why the owning reactor stopped reading this client. True when the
+    // client went from reading to paused or back.
+    enum RecvPause : std::uint8_t {
+        PAUSE_SENDQ = 1 << 0,
+        PAUSE_HELD = 1 << 1,    // lines left over from an earlier pass
+        PAUSE_OVERLOAD = 1 << 2 // a heavy sender while the reactor sheds
+    };
+    bool setRecvPaused(RecvPause reason, bool paused) noexcept;
+    bool isRecvPaused(RecvPause reason) const noexcept;
+
+    // Whether the owning reactor has lines of this client waiting for a
+    // dispatch turn.
+    void setScheduled(bool scheduled) noexcept;
+    bool isScheduled() const noexcept;
+
+  public:
+    // Liveness, on the owning reactor. Every read marks the client heard;
+    // each idle check takes the mark: a client heard since the last check
+    // is fine, one that was not is sent a PING, and one still silent at the
+    // check after that has timed out.
+    void markHeard() noexcept;
+    IdleAction checkIdle() noexcept;
+    // Its timer in the owning reactor's TimerWheel, TimerWheel::NONE if none.
+    void setTimer(std::uint32_t timer) noexcept;
+    std::uint32_t getTimer() const noexcept;
+
+  public:
+    // The client's end of its membership edges, kept by Channel: the
+    // channels it joined, each at the index its Member entry stores.
+    std::uint32_t linkChannel(Channel *channel);
+    // Drops the edge at `edge`; returns the channel whose edge moved into
+    // that index, which must be told, or nullptr.
+    Channel *unlinkChannel(std::uint32_t edge) noexcept;
+    void relinkChannel(std::uint32_t edge, Channel *channel) noexcept;
+    const std::vector<Channel *> &getChannels() const noexcept;
+
+  public:
+    // For Server's NICK/QUIT fan-out, under the state lock: false if this
+    // client was already marked in `epoch`.
+    bool markFanout(std::uint64_t epoch) noexcept;
 
   private:
-    FileDescriptor _fd;
-    std::string _username;
-    std::string _nickname;
-    std::string _ip;
-    std::string _realname;
+    enum Flag : std::uint8_t {
+        USERNAME_SET = 1 << 0,
+        NICKNAME_SET = 1 << 1,
+        PASSWORD_SET = 1 << 2,
+        REGISTERED = USERNAME_SET | NICKNAME_SET | PASSWORD_SET,
+        DISCONNECT = 1 << 3,
+    };
+
+    enum SendQState : std::uint8_t {
+        SENDQ_FULL = 1 << 0,      // refused an append since checkSendQ()
+        SENDQ_THROTTLED = 1 << 1, // dropping (and maybe paused) until drained
+    };
+
+    enum Idle : std::uint8_t {
+        IDLE_HEARD = 1 << 0,  // read from since checkIdle()
+        IDLE_PINGED = 1 << 1, // sent a PING, not heard from since
+    };
 
   private:
-    std::string _partial_buffer;
-    std::queue<std::string> _messages;
-    std::size_t _offset{0};
+    // Hot: what every read, flush and append of this connection touches.
+    FileDescriptor _fd;
+    std::uint32_t _generation;
+    std::uint32_t _reactor{0};
+    std::uint8_t _flags{0};
+    std::uint8_t _sendq_state{0}; // under _send_mutex, unlike _flags
+    std::uint16_t _flood_tokens{0};
+    std::uint32_t _flood_stamp{0}; // when _flood_tokens was last refilled
+    std::uint8_t _recv_paused{0};
+    bool _scheduled{false};
+    std::uint8_t _idle{0};
+    EpollInterface *_epollNotifier{};
+    std::mutex _send_mutex; // appenders on any reactor vs. the owner's flush
+    OutputBuffer _output;
+    std::uint32_t _inflight{0};   // bytes, saturating
+    std::uint32_t _sendq_peak{0}; // bytes, saturating
+    const ConnectionClass *_class{nullptr};
+    LineBuffer _input;
 
   private:
-    epoll_event _event;
-    std::bitset<3> _registered{0}; // user, nick, pass
-    bool _disconnect{false};
+    // Cold: identity and membership, read by commands only.
+    Interned _nickname;
+    Interned _username;
+    Interned _ip;
+    Interned _realname;
+    std::string _prefix; // getFullID(), rebuilt by the setters
+    std::uint64_t _fanout{0};
+    std::uint32_t _sendq_dropped{0};
+    std::uint32_t _timer{0};
+    std::unique_ptr<std::vector<Channel *>> _channels; // from first JOIN
 
   private:
-    std::vector<std::string> _channels;
+    void _updatePrefix();
+    bool _admit(std::size_t bytes) noexcept;
+    void _refill(std::uint32_t now) noexcept;
+    void _queued() noexcept;
 };
 
+#include "../templates/Client.tpp"
+
 #endif // !CLIENT_HPP
@@ -0,0 +1,75 @@
+#ifndef CLIENTSLAB_HPP
+#define CLIENTSLAB_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+
+#include "./Client.hpp"
+
+// Owns every Client, each in the slot indexed by its fd, so finding the
+// client for an event is an array index. Slots come in chunks that are
+// allocated on first use and never move: a Client * stays valid until the
+// slot is destroyed, and clients that connect around the same time share
+// cache lines instead of scattering across the heap.
+//
+// A slot counts the connections it has held. A ClientHandle names one of
+// them and stops resolving once that connection is gone, even after the
+// kernel hands its fd to the next one.
+//
+// create/retire/destroy for one fd run on the reactor that owns it (or
+// after the reactors stopped); only chunk allocation is shared. Once closed,
+// the fd may be accepted by another reactor at once, so destroy() frees the
+// slot before it closes the fd, and create() acquires what that published.
+class ClientSlab final {
+  public:
+    ClientSlab();
+
+    ClientSlab(const ClientSlab &rhs) = delete;
+    ClientSlab &operator=(const ClientSlab &rhs) = delete;
+
+    ClientSlab(ClientSlab &&rhs) noexcept;
+    ClientSlab &operator=(ClientSlab &&rhs) noexcept;
+
+    ~ClientSlab();
+
+  public:
+    // nullptr when fd is beyond the process's descriptor limit.
+    Client *create(int fd);
+    Client *get(int fd) const noexcept;
+    Client *get(ClientHandle handle) const noexcept;
+
+    // A retired client no longer resolves, but stays alive, with its fd
+    // open, until destroy(): code still holding it this loop pass is safe.
+    void retire(int fd) noexcept;
+    void destroy(int fd) noexcept;
+
+    std::size_t capacity() const noexcept;
+
+  private:
+    static constexpr std::size_t CHUNK_SIZE = 256;
+
+    enum class SlotState : std::uint8_t { FREE, LIVE, RETIRED };
+
+    struct Slot {
+        std::aligned_storage<sizeof(Client), alignof(Client)>::type storage;
+        std::uint32_t generation;
+        std::atomic<SlotState> state;
+    };
+
+  private:
+    Slot *_find(int fd) const noexcept;
+    Slot &_claim(int fd);
+    static Client *_client(Slot &slot) noexcept;
+    void _release() noexcept;
+
+  private:
+    std::size_t _capacity;
+    std::unique_ptr<std::atomic<Slot *>[]> _chunks;
+    std::mutex _grow_mutex;
+};
+
+#endif // !CLIENTSLAB_HPP
@@ -0,0 +1,73 @@
+#ifndef CONFIG_HPP
+#define CONFIG_HPP
+
+#include <cstddef>
+
+#include "./Enums.hpp"
+
+// Limits for one class of connection; see Config for the two classes.
+struct ConnectionClass {
+    // SendQ: bytes queued or in flight to the client. A line past it is
+    // dropped, dropped while the client's input is paused until the queue
+    // drains to half, or the client is disconnected ("SendQ exceeded").
+    std::size_t sendq; // bytes, 0 for no limit
+    SendQPolicy sendqPolicy;
+
+    // Flood control: a token bucket in command cost units (see commandCost
+    // in Server.cpp). Lines it cannot pay for wait, with the client's input
+    // paused, until it has refilled.
+    std::size_t floodBurst; // units, at most 65535
+    std::size_t floodRate;  // units per second, 0 for no limit
+};
+
+// Runtime tunables, read once at startup from the environment so the
+// `./ircserv <port> <password>` command line stays as it is.
+struct Config {
+    std::size_t threads{1}; // IRC_THREADS, 0 means one per core
+    IOBackend backend{IOBackend::EPOLL}; // IRC_BACKEND, epoll or io_uring
+
+    // epoll backend
+    std::size_t acceptBatch{64};   // IRC_ACCEPT_BATCH, accepts per wakeup
+    bool edgeTriggered{false};     // IRC_EDGE_TRIGGERED, 0 or 1
+    std::size_t readSize{16384};   // IRC_READ_SIZE, bytes per recv()
+    std::size_t readBudget{65536}; // IRC_READ_BUDGET, per client per wakeup
+
+    // An empty channel is destroyed at once unless it has t, k or l set;
+    // then it is kept this many seconds so its modes survive a rejoin.
+    std::size_t channelLinger{60}; // IRC_CHANNEL_LINGER, 0 destroys at once
+
+    // Dispatch: clients with commands read take turns of dispatchTurn
+    // commands until all are handled or the pass has run dispatchBudget
+    // microseconds; the rest waits for the next pass.
+    std::size_t dispatchTurn{16};     // IRC_DISPATCH_TURN, at least 1
+    std::size_t dispatchBudget{2000}; // IRC_DISPATCH_BUDGET, 0 for no limit
+
+    // Load shedding, see LoopMonitor: the loop lag that starts it, in
+    // microseconds of work per pass, and the ready events plus held
+    // clients per pass that defer accepts by themselves.
+    std::size_t overloadLag{20000};    // IRC_OVERLOAD_LAG, 0 turns it off
+    std::size_t overloadBacklog{1024}; // IRC_OVERLOAD_BACKLOG, 0 ignores it
+
+    // Timeouts in seconds, 0 turns one off. A connection has to register
+    // within registrationTimeout. A client silent for half of idleTimeout
+    // (IRC_IDLE_TIMEOUT) is sent a PING, and dropped if it stays silent for
+    // the other half. An invite lapses after inviteTimeout.
+    std::size_t registrationTimeout{60}; // IRC_REGISTRATION_TIMEOUT
+    std::size_t idleTimeout{static_cast<std::size_t>(Defaults::TIMEOUT)};
+    std::size_t inviteTimeout{3600}; // IRC_INVITE_TIMEOUT
+
+    // Logging, see Logger: the least severe level written (trace, info,
+    // warn, error or off) and how many records may wait to be written.
+    LogLevel logLevel{LogLevel::INFO}; // IRC_LOG_LEVEL
+    std::size_t logRing{4096};         // IRC_LOG_RING, rounded up to 2^n
+
+    // Connection classes, from IRC_<field> for registered clients and
+    // IRC_UNREGISTERED_<field> before that: SENDQ, SENDQ_POLICY (drop, pause
+    // or disconnect), FLOOD_BURST and FLOOD_RATE.
+    ConnectionClass registered{1 << 20, SendQPolicy::DISCONNECT, 1000, 500};
+    ConnectionClass unregistered{1 << 14, SendQPolicy::DISCONNECT, 100, 20};
+};
+
+Config loadConfig() noexcept;
+
+#endif // !CONFIG_HPP
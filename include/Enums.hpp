@@ -20,13 +20,33 @@ enum class Defaults : std::uint16_t {
     TOPICLEN = 512,
     MAXMSGLEN = 512,
     MAXCHANNELLEN = 164,
+    MAXPARAMS = 15,
+    CHANNEL_POOL = 1024,
+    OVERLOAD_TICK = 100,
 };
 bool operator>(std::uint16_t lhs, Defaults rhs);
 bool operator<(std::uint16_t lhs, Defaults rhs);
 std::uint16_t getDefaultValue(Defaults rhs);
 
+enum class IOBackend : std::uint8_t { EPOLL, IO_URING };
+
+enum class SendQPolicy : std::uint8_t { DROP, PAUSE, DISCONNECT };
+
+// Least to most severe; OFF writes nothing.
+enum class LogLevel : std::uint8_t { TRACE, INFO, WARN, ERROR, OFF };
+
+// How much a reactor sheds; each tier also does what the ones below do.
+enum class OverloadTier : std::uint8_t {
+    NORMAL,
+    DEFER_ACCEPT,
+    PAUSE_HEAVY,
+    SHED_FEATURES
+};
+
 enum class ChatBot : std::int8_t {
     CHANNELS,
+    SENDQ,
+    LOAD,
     HELLO,
     JOKE,
     HELP,
@@ -65,6 +85,7 @@ enum class IRCCommand : std::uint8_t {
     PART,
     QUIT,
     PING,
+    PONG,
     KICK,
     INVITE,
     MODE,
@@ -120,6 +141,7 @@ enum class IRCCode : std::int16_t {
     UNKNOWNMODEFLAG = 501,
     USERSDONTMATCH = 502,
     INVALIDMODEPARAM = 696,
+    QUIT = 991,         // for my own use
     INVITENOTICE = 992, // for my own use
     MODE = 993,         // for my own use
     TOPICNOTICE = 994,  // for my own use
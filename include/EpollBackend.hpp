@@ -0,0 +1,88 @@
+#ifndef EPOLLBACKEND_HPP
+#define EPOLLBACKEND_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <sys/epoll.h>
+
+#include "./Config.hpp"
+#include "./AcceptGuard.hpp"
+#include "./EpollInterface.hpp"
+#include "./FileDescriptor.hpp"
+
+// Classic readiness loop. Each readable client is drained until EAGAIN or
+// until it has used its read budget for this wakeup; in edge-triggered mode
+// a client cut off by the budget is carried over to the next wait().
+// Clients are registered for EPOLLIN only: output is written directly in the
+// flush phase and EPOLLOUT is armed just for sockets that hit EAGAIN.
+class EpollBackend final : public EpollInterface {
+  public:
+    explicit EpollBackend(const Config &config);
+
+    EpollBackend(const EpollBackend &rhs) = delete;
+    EpollBackend &operator=(const EpollBackend &rhs) = delete;
+
+    EpollBackend(EpollBackend &&rhs) = delete;
+    EpollBackend &operator=(EpollBackend &&rhs) = delete;
+
+    ~EpollBackend() override = default;
+
+  public:
+    bool init(int listenFD) override;
+    int wait(IOHandler &handler, int timeout) override;
+    const char *getName() const noexcept override;
+    IOStats getStats() const noexcept override;
+
+  public:
+    bool addClient(ClientHandle client) override;
+    void removeClient(int fd) override;
+    FlushResult flush(Client &client) override;
+    void pauseRecv(int fd, bool paused) override;
+    void deferAccept(bool deferred) override;
+    void flushPending(IOHandler &handler) override;
+
+  public:
+    void notifyEpollUpdate(ClientHandle client) override;
+    int getEpollFD() const noexcept override;
+
+  private:
+    void _accept(IOHandler &handler) noexcept;
+    void _recv(IOHandler &handler, int fd) noexcept;
+    void _recvBacklog(IOHandler &handler) noexcept;
+    void _setInterest(int fd, std::uint32_t events) noexcept;
+    void _setWritable(int fd, bool armed) noexcept;
+    std::uint32_t _interest(std::size_t index) const noexcept;
+    ClientHandle _handle(int fd) const noexcept;
+
+  private:
+    FileDescriptor _epoll_fd;
+    FileDescriptor _wake_fd;
+    int _listen_fd{-1};
+    std::vector<epoll_event> _events;
+
+  private:
+    AcceptGuard _accept_guard;
+    std::size_t _accept_batch;
+    bool _accept_deferred{false};
+
+  private:
+    std::uint32_t _edge;
+    std::size_t _read_budget;
+    std::vector<char> _buffer; // scratch for every recv on this reactor
+    std::vector<int> _backlog; // over budget, still readable (edge mode)
+    std::vector<int> _ready;
+
+  private:
+    std::mutex _dirty_mutex;
+    std::vector<ClientHandle> _dirty; // queued output since the last flush
+    std::vector<ClientHandle> _flushing;
+    std::vector<std::uint32_t> _generations; // by fd: see addClient
+    std::vector<bool> _armed;  // by fd: EPOLLOUT registered
+    std::vector<bool> _paused; // by fd: EPOLLIN dropped, see pauseRecv
+};
+
+#endif // !EPOLLBACKEND_HPP
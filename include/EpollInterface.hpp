@@ -1,6 +1,59 @@
 #ifndef EpollInterface_HPP
 #define EpollInterface_HPP
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <netinet/in.h>
+
+class Client;
+
+// Names one connection: the fd plus how many connections that fd's slot
+// had held when this one was accepted. See ClientSlab.
+struct ClientHandle {
+    int fd;
+    std::uint32_t generation;
+};
+
+// Callbacks a backend makes from wait(). Data passed to onRecv is only valid
+// for the duration of the call; onAccept gets a null peer when the backend
+// did not learn the address. Client events carry the handle given to
+// addClient, so the server can drop those meant for an earlier connection.
+class IOHandler {
+  public:
+    IOHandler() = default;
+
+    IOHandler(const IOHandler &) = default;
+    IOHandler &operator=(const IOHandler &) = default;
+
+    IOHandler(IOHandler &&) = default;
+    IOHandler &operator=(IOHandler &&) = default;
+
+    virtual ~IOHandler() = default;
+
+  public:
+    virtual void onAccept(int fd, const sockaddr_in *peer) = 0;
+    virtual void onRecv(ClientHandle client, const char *data,
+                        std::size_t length) = 0;
+    virtual void onWritable(ClientHandle client) = 0;
+    virtual void onClosed(ClientHandle client) = 0;
+    virtual void onAux(int fd, std::uint32_t events) = 0;
+};
+
+enum class FlushResult : std::uint8_t { DONE, PENDING, FAILED };
+
+// Running totals since the backend started; safe to read from any thread.
+struct IOStats {
+    std::uint64_t accepted;
+    std::uint64_t acceptFailed;
+    std::uint64_t acceptShed; // dropped to recover from EMFILE/ENFILE
+};
+
+// An event loop engine owned by one reactor. Everything except
+// notifyEpollUpdate runs on the reactor's thread, which drives it in phases:
+// wait() reads, the server dispatches what was read, and flushPending()
+// writes out whatever that queued.
 class EpollInterface {
   public:
     EpollInterface() = default;
@@ -14,7 +67,34 @@ class EpollInterface {
     virtual ~EpollInterface() = default;
 
   public:
-    virtual void notifyEpollUpdate(int fd) = 0;
+    virtual bool init(int listenFD) = 0;
+    virtual int wait(IOHandler &handler, int timeout) = 0;
+    virtual const char *getName() const noexcept = 0;
+    virtual IOStats getStats() const noexcept = 0;
+
+  public:
+    // Backends hand the handle back with every write event, so a late
+    // event for an fd that was reused is told apart from the new client.
+    virtual bool addClient(ClientHandle client) = 0;
+    virtual void removeClient(int fd) = 0;
+    virtual FlushResult flush(Client &client) = 0;
+    // Stops reading fd while its SendQ drains, and starts again.
+    virtual void pauseRecv(int fd, bool paused) = 0;
+    // Leaves new connections in the listen backlog while the reactor sheds
+    // load, and takes them again.
+    virtual void deferAccept(bool deferred) = 0;
+    // Offers every client marked by notifyEpollUpdate to onWritable.
+    virtual void flushPending(IOHandler &handler) = 0;
+
+  public:
+    // Any thread: the client went from nothing queued to something queued.
+    // Only marks it; the write happens in the flush phase, which skips it
+    // if the connection is gone by then.
+    virtual void notifyEpollUpdate(ClientHandle client) = 0;
+
+    // Epoll instance for auxiliary sockets (chatbot API requests); they are
+    // reported back through IOHandler::onAux.
+    virtual int getEpollFD() const noexcept = 0;
 };
 
 #endif // EpollInterface_HPP
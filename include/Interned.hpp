@@ -0,0 +1,40 @@
+#ifndef INTERNED_HPP
+#define INTERNED_HPP
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+// A string stored once per process and shared by every holder, reference
+// counted. Idle connections mostly repeat the same user, host and realname,
+// so each client keeps a pointer instead of its own copy. Interning and
+// releasing take the pool's lock; reading does not.
+class Interned final {
+  public:
+    Interned() noexcept = default;
+    explicit Interned(const std::string &value);
+
+    Interned(const Interned &rhs) noexcept;
+    Interned &operator=(const Interned &rhs) noexcept;
+
+    Interned(Interned &&rhs) noexcept;
+    Interned &operator=(Interned &&rhs) noexcept;
+
+    ~Interned();
+
+  public:
+    const std::string &str() const noexcept;
+    bool empty() const noexcept;
+
+  private:
+    using Entry = std::pair<const std::string, std::size_t>;
+
+  private:
+    void _acquire() const noexcept;
+    void _release() noexcept;
+
+  private:
+    Entry *_entry{nullptr}; // nullptr for ""
+};
+
+#endif // !INTERNED_HPP
@@ -0,0 +1,49 @@
+#ifndef LINEBUFFER_HPP
+#define LINEBUFFER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Splits a client's byte stream into CRLF-terminated lines. Complete lines
+// are handed out straight from the caller's read buffer; only the
+// unterminated tail is copied, and never more than `limit` bytes of it.
+// A line that outgrows the limit is reported once and its remaining bytes
+// are skipped as they arrive instead of being buffered.
+class LineBuffer final {
+  public:
+    explicit LineBuffer(std::size_t limit) noexcept;
+
+    LineBuffer(const LineBuffer &rhs) = delete;
+    LineBuffer &operator=(const LineBuffer &rhs) = delete;
+
+    LineBuffer(LineBuffer &&rhs) noexcept;
+    LineBuffer &operator=(LineBuffer &&rhs) noexcept;
+
+    ~LineBuffer() = default;
+
+  public:
+    // Calls sink(line, length, false) for every complete line in `data`,
+    // without its CRLF, and sink(nullptr, 0, true) once for each line that
+    // is longer than the limit. A line is only valid during the call.
+    template <typename Sink>
+    void feed(const char *data, std::size_t length, Sink &&sink);
+
+  public:
+    bool empty() const noexcept;
+    std::size_t capacity() const noexcept;
+
+  private:
+    bool _keep(const char *data, std::size_t length) noexcept;
+    void _release() noexcept;
+
+  private:
+    std::string _tail; // unterminated bytes, or just a pending '\r' when
+                       // skipping
+    std::uint32_t _limit; // a line length, so 32 bits keep Client small
+    bool _skipping{false};
+};
+
+#include "../templates/LineBuffer.tpp"
+
+#endif // !LINEBUFFER_HPP
@@ -0,0 +1,144 @@
+#ifndef LOGGER_HPP
+#define LOGGER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+#include "./Config.hpp"
+#include "./Enums.hpp"
+#include "./StringView.hpp"
+
+// Writes log records to stderr from a thread of its own, so a reactor never
+// waits on the terminal or a slow pipe. Records are copied into a bounded
+// ring that any thread may push to without a lock; the writer takes them
+// out in order and writes them in batches of up to 64 KiB. A record that
+// finds the ring full is dropped and counted, and the writer reports the
+// count in place of the lost records.
+//
+// There is one logger, made in main() before the server and destroyed after
+// it; the destructor writes out what is left. Without a logger, as at
+// startup, records are written to stderr at once.
+class Logger final {
+  public:
+    static constexpr std::size_t TEXT = 496; // record bytes, longer is cut
+
+  public:
+    explicit Logger(const Config &config);
+
+    Logger(const Logger &rhs) = delete;
+    Logger &operator=(const Logger &rhs) = delete;
+
+    Logger(Logger &&rhs) = delete;
+    Logger &operator=(Logger &&rhs) = delete;
+
+    ~Logger();
+
+  public:
+    // One relaxed load; IRC_LOG checks this before formatting anything.
+    static bool enabled(const LogLevel level) noexcept {
+        return level >= _level.load(std::memory_order_relaxed);
+    }
+
+    static void submit(LogLevel level, const char *text,
+                       std::size_t length) noexcept;
+
+  private:
+    // 512 bytes. `sequence` says whose turn the slot is: it equals the
+    // position a producer may fill, then that plus one for the writer.
+    struct Slot {
+        std::atomic<std::uint64_t> sequence;
+        std::uint16_t length;
+        char text[TEXT];
+    };
+
+  private:
+    void _push(const char *text, std::size_t length) noexcept;
+    void _write() noexcept;
+    void _drain() noexcept;
+    void _flush() noexcept;
+
+  private:
+    static std::atomic<LogLevel> _level;
+    static std::atomic<Logger *> _active;
+
+  private:
+    std::unique_ptr<Slot[]> _ring;
+    std::uint64_t _mask;
+    alignas(64) std::atomic<std::uint64_t> _head{0}; // next to fill
+    alignas(64) std::atomic<std::uint64_t> _dropped{0};
+
+  private:
+    // Writer thread only.
+    alignas(64) std::uint64_t _tail{0}; // next to write
+    std::uint64_t _reported{0};         // drops already written about
+    std::string _batch;
+
+  private:
+    std::atomic<bool> _stop{false};
+    std::thread _writer;
+};
+
+// One record, formatted on the stack and handed to the logger when the
+// statement ends. Made by IRC_LOG, not by hand.
+class LogLine final {
+  public:
+    explicit LogLine(LogLevel level) noexcept;
+
+    LogLine(const LogLine &rhs) = delete;
+    LogLine &operator=(const LogLine &rhs) = delete;
+
+    LogLine(LogLine &&rhs) = delete;
+    LogLine &operator=(LogLine &&rhs) = delete;
+
+    ~LogLine();
+
+  public:
+    LogLine &operator<<(const char *text) noexcept;
+    LogLine &operator<<(const std::string &text) noexcept;
+    LogLine &operator<<(const StringView &text) noexcept; // raw bytes
+    LogLine &operator<<(char c) noexcept;
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value &&
+                                !std::is_same<T, char>::value &&
+                                !std::is_same<T, bool>::value,
+                            LogLine &>::type
+    operator<<(T value) noexcept;
+
+  private:
+    void _append(const char *text, std::size_t length) noexcept;
+    void _number(long long value) noexcept;
+    void _number(unsigned long long value) noexcept;
+
+  private:
+    LogLevel _level;
+    std::size_t _length{0};
+    bool _cut{false};
+    char _text[Logger::TEXT];
+};
+
+// Turns a finished LogLine into void, so IRC_LOG can be one conditional
+// expression. `&` binds looser than `<<`, so it takes the whole line.
+class LogVoid final {
+  public:
+    void operator&(const LogLine &line) const noexcept {
+        static_cast<void>(line);
+    }
+};
+
+// IRC_LOG(WARN) << "Client FD: " << fd << " SendQ exceeded";
+// The operands are not evaluated unless the level is enabled. A single
+// expression, so it is safe as the body of an unbraced if with an else.
+#define IRC_LOG(level)                                                         \
+    Logger::enabled(LogLevel::level) != true                                   \
+        ? static_cast<void>(0)                                                 \
+        : LogVoid() & LogLine(LogLevel::level)
+
+#include "../templates/Logger.tpp"
+
+#endif // !LOGGER_HPP
@@ -0,0 +1,71 @@
+#ifndef LOOPMONITOR_HPP
+#define LOOPMONITOR_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "./Config.hpp"
+#include "./Enums.hpp"
+
+// One reactor's load; safe to read from any thread.
+struct LoadStats {
+    OverloadTier tier;
+    std::uint64_t lagUsec;       // smoothed work per loop pass
+    std::uint64_t backlog;       // ready events plus held clients, last pass
+    std::uint64_t transitions;   // tier changes since start
+    std::uint64_t pausedClients; // heavy senders paused since start
+};
+
+// Picks how much load a reactor sheds. Every loop pass reports how long it
+// worked outside wait() and how much it left waiting. The smoothed work
+// time, the loop's lag, selects the tier: at the configured lag new accepts
+// are deferred, at twice that the heaviest senders are paused, at four times
+// costly features are turned off. A backlog at its limit alone defers
+// accepts. Tiers go up at once and come down a step at a time, once the lag
+// is under half of what the current tier took and the tier has been held
+// for a wait interval, so shedding that works is not undone the next pass.
+class LoopMonitor final {
+  public:
+    LoopMonitor() = default;
+
+    LoopMonitor(const LoopMonitor &rhs) = delete;
+    LoopMonitor &operator=(const LoopMonitor &rhs) = delete;
+
+    LoopMonitor(LoopMonitor &&rhs) = delete;
+    LoopMonitor &operator=(LoopMonitor &&rhs) = delete;
+
+    ~LoopMonitor() = default;
+
+  public:
+    void init(const Config &config) noexcept;
+    // Owning reactor only; true when the tier changed.
+    bool sample(std::chrono::steady_clock::time_point now,
+                std::chrono::microseconds busy, std::size_t backlog) noexcept;
+    void pausedClient() noexcept;
+
+  public:
+    OverloadTier getTier() const noexcept;
+    LoadStats getStats() const noexcept;
+
+  private:
+    std::uint64_t _enterAt(OverloadTier tier) const noexcept;
+
+  private:
+    std::uint64_t _lag_limit{0}; // microseconds, 0 never sheds
+    std::size_t _backlog_limit{0};
+    std::uint64_t _lag{0}; // microseconds, owning reactor only
+    std::chrono::steady_clock::time_point _changed; // owning reactor only
+
+  private:
+    std::atomic<OverloadTier> _tier{OverloadTier::NORMAL};
+    std::atomic<std::uint64_t> _shown_lag{0};
+    std::atomic<std::uint64_t> _shown_backlog{0};
+    std::atomic<std::uint64_t> _transitions{0};
+    std::atomic<std::uint64_t> _paused{0};
+};
+
+const char *toString(OverloadTier tier) noexcept;
+
+#endif // !LOOPMONITOR_HPP
@@ -0,0 +1,95 @@
+#ifndef MEMBERTABLE_HPP
+#define MEMBERTABLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "./Client.hpp"
+
+enum class MemberFlag : std::uint8_t {
+    JOINED = 1 << 0,
+    OPERATOR = 1 << 1,
+    VOICE = 1 << 2,
+    INVITED = 1 << 3,
+};
+
+struct Member {
+    Client *client;
+    // Joined: this channel's index in client->getChannels(). Only invited:
+    // the generation of the connection that was invited (see ClientHandle).
+    std::uint32_t edge;
+    std::uint8_t flags;
+    std::uint16_t serial; // of the invite, while only invited
+
+    bool has(MemberFlag flag) const noexcept;
+};
+
+// Everyone a channel knows about, one entry per client with its flags.
+// Entries live in one vector with the joined members packed at the front,
+// so a broadcast walks contiguous memory and never sees a client that was
+// only invited. An index from client to slot makes every flag test O(1);
+// removal swaps the last entry of the region into the hole.
+//
+// A joined entry is one end of a membership edge; the client holds the
+// other (see Client::linkChannel). Each end stores the other's position,
+// so Channel can drop the edge from both sides in O(1).
+//
+// An invite names one connection, not the Client object, whose slot the
+// next connection on the same fd reuses: it only counts for the generation
+// it was made for. Each invite gets a serial, so the timer of an earlier
+// invite of the same client cannot expire a later one.
+class MemberTable final {
+  public:
+    MemberTable() = default;
+
+    MemberTable(const MemberTable &rhs) = delete;
+    MemberTable &operator=(const MemberTable &rhs) = delete;
+
+    MemberTable(MemberTable &&rhs) noexcept;
+    MemberTable &operator=(MemberTable &&rhs) noexcept;
+
+    ~MemberTable() = default;
+
+  public:
+    bool has(Client *client, MemberFlag flag) const noexcept;
+    void set(Client *client, MemberFlag flag);
+    void clear(Client *client, MemberFlag flag) noexcept;
+
+  public:
+    // The new invite's serial, never 0; `client` must not have joined.
+    std::uint16_t invite(Client *client, std::uint32_t generation);
+    bool invited(const Client *client,
+                 std::uint32_t generation) const noexcept;
+    // Drops the invite if it is still the one with `serial`.
+    bool expire(Client *client, std::uint32_t generation,
+                std::uint16_t serial) noexcept;
+    // Drops the entries of everyone invited who has not joined.
+    void dropInvites() noexcept;
+
+  public:
+    std::uint32_t edge(Client *client) const noexcept;
+    void setEdge(Client *client, std::uint32_t edge) noexcept;
+
+  public:
+    std::size_t joined() const noexcept;
+    std::size_t operators() const noexcept;
+
+    // The joined members only.
+    const Member *begin() const noexcept;
+    const Member *end() const noexcept;
+
+  private:
+    void _swap(std::size_t lhs, std::size_t rhs) noexcept;
+
+  private:
+    std::vector<Member> _entries; // [0, _joined) joined, then invited only
+    std::unordered_map<const Client *, std::size_t> _index;
+    std::size_t _joined{0};
+    std::size_t _operators{0};
+    std::uint16_t _serial{0}; // of the last invite
+};
+
+#endif // !MEMBERTABLE_HPP
@@ -0,0 +1,67 @@
+#ifndef OUTPUTBUFFER_HPP
+#define OUTPUTBUFFER_HPP
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sys/uio.h>
+
+// An immutable, formatted line shared by every queue it was appended to,
+// so a broadcast is formatted once however many members receive it.
+using Payload = std::shared_ptr<const std::string>;
+
+Payload makePayload(std::string line);
+
+// Bytes queued for one client: its own lines stored back to back in
+// fixed-size chunks, interleaved with references to shared payloads.
+// Appends never move bytes already stored, so a flush can hand the kernel an
+// iovec over many lines and keep appending while that write is in flight.
+class OutputBuffer final {
+  public:
+    OutputBuffer() = default;
+
+    OutputBuffer(const OutputBuffer &rhs) = delete;
+    OutputBuffer &operator=(const OutputBuffer &rhs) = delete;
+
+    OutputBuffer(OutputBuffer &&rhs) noexcept;
+    OutputBuffer &operator=(OutputBuffer &&rhs) noexcept;
+
+    ~OutputBuffer() = default;
+
+  public:
+    void append(const char *data, std::size_t length);
+    void append(const std::string &data);
+    void append(const Payload &payload);
+
+  public:
+    bool empty() const noexcept;
+    std::size_t size() const noexcept;
+
+  public:
+    // Points up to `count` iovecs at the oldest unsent bytes; returns how
+    // many were filled.
+    std::size_t fillIov(iovec *iov, std::size_t count) const noexcept;
+    void consume(std::size_t bytes) noexcept;
+    void clear() noexcept;
+
+  private:
+    // Either an owned chunk or a shared payload; begin/end index into
+    // whichever is set.
+    struct Segment {
+        std::unique_ptr<char[]> data;
+        Payload shared;
+        std::size_t begin;
+        std::size_t end;
+    };
+
+  private:
+    // Consumed from _head on, compacted once the dead prefix dominates;
+    // unlike a deque, an empty vector owns no memory.
+    std::vector<Segment> _segments;
+    std::size_t _head{0};
+    std::size_t _size{0};
+};
+
+#endif // !OUTPUTBUFFER_HPP
@@ -0,0 +1,85 @@
+#ifndef REACTOR_HPP
+#define REACTOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "./Client.hpp"
+#include "./Config.hpp"
+#include "./EpollInterface.hpp"
+#include "./FileDescriptor.hpp"
+#include "./LoopMonitor.hpp"
+#include "./TimerWheel.hpp"
+#include "./Token.hpp"
+
+struct ApiRequest {
+    int fd;
+    ClientHandle client; // may be gone by the time the API answers
+    std::string buffer;
+    std::string request;
+    enum State { CONNECTING, SENDING, READING } state;
+};
+
+// Commands one client sent, parsed and waiting for the dispatch phase; the
+// ones before `next` have been handled.
+struct Inbound {
+    Client *client;
+    std::vector<IRCMessage> tokens;
+    std::size_t next;
+};
+
+// One event loop: its own SO_REUSEPORT listener and I/O backend, serving
+// the clients the kernel handed to that listener. Those live in the server's
+// ClientSlab; other threads reach them only through the shared channel /
+// nick state in Server.
+class Reactor final {
+  public:
+    explicit Reactor(std::size_t id);
+
+    Reactor(const Reactor &rhs) = delete;
+    Reactor &operator=(const Reactor &rhs) = delete;
+
+    Reactor(Reactor &&rhs) = delete;
+    Reactor &operator=(Reactor &&rhs) = delete;
+
+    ~Reactor() = default;
+
+  public:
+    bool init(std::uint16_t port, const Config &config) noexcept;
+    std::size_t getID() const noexcept;
+    int getListenFD() const noexcept;
+    int getEpollFD() const noexcept;
+    EpollInterface &backend() noexcept;
+    LoopMonitor &monitor() noexcept;
+    const LoopMonitor &monitor() const noexcept;
+
+  public:
+    std::unordered_map<int, ApiRequest> &apiRequests() noexcept;
+    std::vector<Inbound> &inbox() noexcept;
+    std::vector<Inbound> &held() noexcept;
+    std::vector<ClientHandle> &paused() noexcept;
+    std::vector<ClientHandle> &closed() noexcept;
+    std::vector<int> &retired() noexcept;
+    TimerWheel<ClientHandle> &timers() noexcept;
+
+  private:
+    std::size_t _id;
+    FileDescriptor _listen_fd;
+    std::unique_ptr<EpollInterface> _backend;
+    LoopMonitor _monitor;
+
+  private:
+    std::unordered_map<int, ApiRequest> _api_requests;
+    std::vector<Inbound> _inbox;       // read this pass, to dispatch
+    std::vector<Inbound> _held;        // still to dispatch, in turn order
+    std::vector<ClientHandle> _paused; // heavy senders, paused for overload
+    std::vector<ClientHandle> _closed; // hung up this pass, see _removeClosed
+    std::vector<int> _retired;         // removed this pass, destroyed at end
+    TimerWheel<ClientHandle> _timers;  // one per client, see Server::_runTimers
+};
+
+#endif // !REACTOR_HPP
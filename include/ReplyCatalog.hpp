@@ -0,0 +1,72 @@
+#ifndef REPLYCATALOG_HPP
+#define REPLYCATALOG_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "./Client.hpp"
+#include "./Enums.hpp"
+
+// Every line handleMsg can send, as a table. Each entry is compiled once
+// into literal runs, with the server name, padded numeric and other
+// constants already rendered in, and the slots a reply fills per
+// recipient. Writing a reply appends those pieces straight into a sink,
+// without formatting an intermediate string.
+struct ReplyPiece {
+    enum Kind : std::uint8_t {
+        TEXT,
+        NICK,
+        NICK_OR_STAR, // "*" before a nick is set
+        FULL_ID,
+        VALUE,
+        MSG,
+    };
+
+    Kind kind;
+    std::uint16_t offset; // into ReplyFormat::text, for TEXT
+    std::uint16_t length;
+};
+
+struct ReplyFormat {
+    std::string text;
+    std::vector<ReplyPiece> pieces;
+};
+
+class ReplyCatalog final {
+  public:
+    static const ReplyCatalog &instance();
+
+  public:
+    ReplyCatalog(const ReplyCatalog &rhs) = delete;
+    ReplyCatalog &operator=(const ReplyCatalog &rhs) = delete;
+
+    ReplyCatalog(ReplyCatalog &&rhs) = delete;
+    ReplyCatalog &operator=(ReplyCatalog &&rhs) = delete;
+
+    ~ReplyCatalog() = default;
+
+  public:
+    // nullptr for a code without a catalog entry.
+    const ReplyFormat *find(IRCCode code) const noexcept;
+
+  private:
+    ReplyCatalog();
+    void _compile(IRCCode code, bool numeric, const char *format);
+
+  private:
+    std::vector<ReplyFormat> _formats; // indexed by code
+};
+
+// Calls sink(data, length) for each piece of the line, CRLF included.
+// `client` is the recipient; relays, which never mention it, may pass
+// nullptr.
+template <typename Sink>
+void writeReply(const ReplyFormat &format, const Client *client,
+                const std::string &value, const std::string &msg,
+                Sink &&sink);
+
+#include "../templates/ReplyCatalog.tpp"
+
+#endif // !REPLYCATALOG_HPP
@@ -1,27 +1,29 @@
 #ifndef SERVER_HPP
 #define SERVER_HPP
 
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
+#include "./CaseMap.hpp"
 #include "./Channel.hpp"
 #include "./Client.hpp"
-#include "./EpollInterface.hpp"
-#include "./FileDescriptor.hpp"
+#include "./ClientSlab.hpp"
+#include "./Config.hpp"
+#include "./Reactor.hpp"
+#include "./TimerWheel.hpp"
 #include "./Token.hpp"
 
-struct ApiRequest {
-    int fd;
-    std::shared_ptr<Client> client;
-    std::string buffer;
-    std::string request;
-    enum State { CONNECTING, SENDING, READING } state;
-};
-
-class Server final : public EpollInterface {
+class Server final {
   public:
-    explicit Server(const std::string &port, std::string &password);
+    explicit Server(const std::string &port, std::string &password,
+                    const Config &config);
 
     Server(const Server &rhs) = delete;
     Server &operator=(const Server &rhs) = delete;
@@ -29,7 +31,7 @@ class Server final : public EpollInterface {
     Server(Server &&rhs) noexcept;
     Server &operator=(Server &&rhs) noexcept;
 
-    ~Server() override;
+    ~Server();
 
   public:
     class ServerException final : public std::exception {
@@ -37,66 +39,92 @@ class Server final : public EpollInterface {
         const char *what() const noexcept override;
     };
 
-  public:
-    void notifyEpollUpdate(int fd) override;
-
   public:
     bool init() noexcept;
     bool run() noexcept;
 
   public:
     std::string getChannelsAndUsers() noexcept;
+    std::string getSendQStats() noexcept;
+    std::string getLoadStats() const noexcept;
+    bool isShedding() const noexcept;
     int getEpollFD() const noexcept;
     void addApiRequest(const ApiRequest &api) noexcept;
 
   private:
     bool _init() noexcept;
-    void _run();
+    void _run(Reactor &reactor);
     void _shutdown() noexcept;
-    static int _setNonBlocking(int fd) noexcept;
+    void _removeClosed(Reactor &reactor) noexcept;
+    void _reap(Reactor &reactor) noexcept;
+    void _sweepChannels() noexcept;
+    void _runTimers(Reactor &reactor) noexcept;
+    static void _armTimer(Reactor &reactor, Client *client,
+                          std::chrono::milliseconds delay) noexcept;
+    void _checkLoad(Reactor &reactor, std::chrono::microseconds busy,
+                    std::size_t ready) noexcept;
+
+  private:
+    class ReactorHandler;
+
+    // A moded channel left empty at `emptiedAt`; stale once the channel was
+    // rejoined, destroyed or emptied again since.
+    struct Lingering {
+        std::string name;
+        std::chrono::steady_clock::time_point emptiedAt;
+    };
+
+    // An invite to expire, looked up by channel name as the channel may be
+    // gone by then; `client` is only compared, never followed.
+    struct Invite {
+        std::string channel;
+        Client *client;
+        std::uint32_t generation;
+        std::uint16_t serial;
+    };
 
   private:
-    void _newConnection() noexcept;
-    void _clientAccepted(const std::shared_ptr<Client> &client) noexcept;
-    void _clientRecv(int fd) noexcept;
-    void _clientSend(int fd) noexcept;
-    void _removeClient(const std::shared_ptr<Client> &client) noexcept;
+    void _newConnection(Reactor &reactor, int clientFD,
+                        const sockaddr_in *peer) noexcept;
+    void _clientAccepted(Client *client) noexcept;
+    void _clientRecv(Reactor &reactor, ClientHandle handle, const char *data,
+                     std::size_t length) noexcept;
+    void _clientSend(Reactor &reactor, ClientHandle handle) noexcept;
+    void _clientClosed(Reactor &reactor, ClientHandle handle) noexcept;
+    void _apiEvent(Reactor &reactor, int fd, std::uint32_t events) noexcept;
+    void _removeClient(Client *client,
+                       const std::string &reason = "") noexcept;
+    static void _dropInbound(Reactor &reactor, const Client *client) noexcept;
     Channel *isChannel(const std::string &channelName) noexcept;
+    void _releaseIfEmpty(Channel *channel) noexcept;
+    const std::vector<Client *> &_collectPeers(Client *client) noexcept;
+    void _sendToPeers(Client *client, const Payload &payload) noexcept;
+    static void _pauseRecv(Reactor &reactor, Client *client,
+                           Client::RecvPause reason, bool paused) noexcept;
 
   private:
-    void _processMessage(const std::shared_ptr<Client> &client) noexcept;
-    void _handleCommand(const IRCMessage &token,
-                        const std::shared_ptr<Client> &client) noexcept;
+    void _dispatch(Reactor &reactor) noexcept;
+    std::size_t _dispatchMessages(Inbound &entry, std::size_t turn,
+                                  std::uint32_t now) noexcept;
+    void _handleCommand(const IRCMessage &token, Client *client) noexcept;
 
   private:
-    void _handleNickname(const IRCMessage &token,
-                         const std::shared_ptr<Client> &client) noexcept;
-    void _handleUsername(const IRCMessage &token,
-                         const std::shared_ptr<Client> &client) noexcept;
+    void _handleNickname(const IRCMessage &token, Client *client) noexcept;
+    void _handleUsername(const IRCMessage &token, Client *client) noexcept;
     void _handlePassword(const IRCMessage &token,
-                         const std::shared_ptr<Client> &client) const noexcept;
-    void _handlePriv(const IRCMessage &token,
-                     const std::shared_ptr<Client> &client) noexcept;
-    void _handleJoin(const IRCMessage &token,
-                     const std::shared_ptr<Client> &client) noexcept;
-    void _handleTopic(const IRCMessage &token,
-                      const std::shared_ptr<Client> &client) noexcept;
-    void _handlePart(const IRCMessage &token,
-                     const std::shared_ptr<Client> &client) noexcept;
-    static void _handlePing(const IRCMessage &token,
-                            const std::shared_ptr<Client> &client) noexcept;
-    void _handleKick(const IRCMessage &token,
-                     const std::shared_ptr<Client> &client) noexcept;
-    void _handleInvite(const IRCMessage &token,
-                       const std::shared_ptr<Client> &client) noexcept;
-    void _handleMode(const IRCMessage &token,
-                     const std::shared_ptr<Client> &client) noexcept;
+                         Client *client) const noexcept;
+    void _handlePriv(const IRCMessage &token, Client *client) noexcept;
+    void _handleJoin(const IRCMessage &token, Client *client) noexcept;
+    void _handleTopic(const IRCMessage &token, Client *client) noexcept;
+    void _handlePart(const IRCMessage &token, Client *client) noexcept;
+    static void _handlePing(const IRCMessage &token, Client *client) noexcept;
+    void _handleKick(const IRCMessage &token, Client *client) noexcept;
+    void _handleInvite(const IRCMessage &token, Client *client) noexcept;
+    void _handleMode(const IRCMessage &token, Client *client) noexcept;
     void _handleUserhost(const IRCMessage &token,
-                         const std::shared_ptr<Client> &client) const noexcept;
-    static void _handleUnkown(const IRCMessage &token,
-                              const std::shared_ptr<Client> &client) noexcept;
-    void _handleWhois(const IRCMessage &token,
-                      const std::shared_ptr<Client> &client) const noexcept;
+                         Client *client) const noexcept;
+    static void _handleUnkown(const IRCMessage &token, Client *client) noexcept;
+    void _handleWhois(const IRCMessage &token, Client *client) const noexcept;
 
   private:
     std::uint16_t _port;
@@ -104,15 +132,27 @@ class Server final : public EpollInterface {
     std::string _serverStared;
 
   private:
-    FileDescriptor _server_fd;
-    FileDescriptor _epoll_fd;
+    Config _config;
+    std::vector<std::unique_ptr<Reactor>> _reactors;
     std::size_t _connections{0};
 
   private:
-    std::unordered_map<int, std::shared_ptr<Client>> _fd_to_client;
-    std::unordered_map<std::string, std::shared_ptr<Client>> _nick_to_client;
-    std::unordered_map<std::string, Channel> _channels;
-    std::unordered_map<int, ApiRequest> _api_requests;
+    // Declared first so it outlives every pointer the tables below hold.
+    ClientSlab _clients;
+
+  private:
+    // Held while a command is dispatched; guards the nick and channel state
+    // below, which is shared by every reactor.
+    std::mutex _state_mutex;
+    CaseMap<Client *> _nick_to_client; // rfc1459-folded
+    CaseMap<std::unique_ptr<Channel>> _channels; // folded, as first joined
+    std::deque<Lingering> _lingering; // emptied with modes, oldest first
+    TimerWheel<Invite> _invites; // run by reactor 0, see _sweepChannels
+    std::vector<Client *> _peers; // scratch for _collectPeers
+    std::uint64_t _fanout_epoch{0}; // never wraps, so never reset
+
+  private:
+    std::chrono::steady_clock::time_point _next_sweep; // reactor 0 only
 };
 
 #endif // !SERVER_HPP
@@ -0,0 +1,34 @@
+#ifndef STRINGVIEW_HPP
+#define STRINGVIEW_HPP
+
+#include <cstddef>
+#include <string>
+
+// A non-owning slice of a character buffer. The buffer must outlive it.
+class StringView final {
+  public:
+    StringView() noexcept;
+    StringView(const char *data, std::size_t size) noexcept;
+
+    StringView(const StringView &rhs) = default;
+    StringView &operator=(const StringView &rhs) = default;
+
+    StringView(StringView &&rhs) noexcept = default;
+    StringView &operator=(StringView &&rhs) noexcept = default;
+
+    ~StringView() = default;
+
+  public:
+    const char *data() const noexcept;
+    std::size_t size() const noexcept;
+    bool empty() const noexcept;
+    char operator[](std::size_t index) const noexcept;
+    bool equals(const char *str, std::size_t size) const noexcept;
+    std::string str() const;
+
+  private:
+    const char *_data;
+    std::size_t _size;
+};
+
+#endif // !STRINGVIEW_HPP
@@ -0,0 +1,87 @@
+#ifndef TIMERWHEEL_HPP
+#define TIMERWHEEL_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Timers with a fixed tick, for timeouts of seconds to days: idle clients,
+// registration stragglers, invites. Four levels of 64 slots each; level n
+// holds what expires within 64^(n+1) ticks, and a level's slot is moved one
+// level down when the level below has gone round once. Arming and cancelling
+// link or unlink one node, O(1); each tick touches its own slot plus, every
+// 64 ticks, one slot being moved down. Nothing is scanned for timers that
+// are not due, however many are armed.
+//
+// A timer is named by the id arm() returned until it fired or was
+// cancelled; after that the id may name a new timer, so whoever keeps an id
+// must forget it when its timer fires. Not thread-safe.
+template <typename T>
+class TimerWheel final {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::uint32_t NONE = 0; // never an armed timer's id
+
+  public:
+    explicit TimerWheel(std::chrono::milliseconds tick);
+
+    TimerWheel(const TimerWheel &rhs) = delete;
+    TimerWheel &operator=(const TimerWheel &rhs) = delete;
+
+    TimerWheel(TimerWheel &&rhs) noexcept = default;
+    TimerWheel &operator=(TimerWheel &&rhs) noexcept = default;
+
+    ~TimerWheel() = default;
+
+  public:
+    // Fires `delay` to `delay` plus two ticks after the last advance();
+    // delays past the wheel's range, 2^24 ticks, are clamped.
+    std::uint32_t arm(std::chrono::milliseconds delay, T value);
+    void cancel(std::uint32_t id) noexcept;
+
+    // Runs fire(value) for every timer due by `now`, in tick order. fire
+    // may arm and cancel timers, including ones due in the same call.
+    template <typename Fire>
+    void advance(Clock::time_point now, Fire &&fire);
+
+  public:
+    std::size_t size() const noexcept;
+    // Until the next tick while any timer is armed, else `most`.
+    std::chrono::milliseconds untilTick(
+        Clock::time_point now, std::chrono::milliseconds most) const noexcept;
+
+  private:
+    static constexpr std::uint32_t LEVELS = 4;
+    static constexpr std::uint32_t SLOT_BITS = 6;
+    static constexpr std::uint32_t SLOTS = 1U << SLOT_BITS;
+    static constexpr std::uint32_t HEADS = LEVELS * SLOTS;
+
+    // Nodes [0, HEADS) head the slots' circular lists; the rest are timers,
+    // linked in a slot or, through `next`, in the free list.
+    struct Node {
+        T value;
+        std::uint32_t next;
+        std::uint32_t prev;
+        std::uint32_t expires; // tick
+    };
+
+  private:
+    void _link(std::uint32_t id) noexcept;
+    void _unlink(std::uint32_t id) noexcept;
+    void _release(std::uint32_t id) noexcept;
+    std::uint32_t _cascade(std::uint32_t level) noexcept;
+
+  private:
+    std::chrono::milliseconds _tick;
+    Clock::time_point _origin;
+    std::uint32_t _next{0}; // the first tick since _origin not run yet
+    std::vector<Node> _nodes;
+    std::uint32_t _free{NONE};
+    std::size_t _armed{0};
+};
+
+#include "../templates/TimerWheel.tpp"
+
+#endif // !TIMERWHEEL_HPP
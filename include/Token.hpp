@@ -1,11 +1,13 @@
 #ifndef TOKEN_HPP
 #define TOKEN_HPP
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
 #include "./Enums.hpp"
 #include "./Optional.hpp"
+#include "./StringView.hpp"
 
 struct IRCMessage {
     std::string prefix;
@@ -19,6 +21,23 @@ struct IRCMessage {
     IRCCommand type;
 };
 
-std::vector<IRCMessage> parseIRCMessage(const std::string &msg);
+// One line as it sits in the receive buffer. Every field points into that
+// line, so a view is only valid while the line is.
+struct MessageView {
+    StringView prefix;
+    StringView command;
+    StringView params[static_cast<std::size_t>(Defaults::MAXPARAMS)];
+    std::size_t paramCount;
+    IRCCommand type;
+};
+
+// Splits one line without CRLF into a view; allocates nothing. Returns false
+// when the line holds no command.
+bool parseMessage(const char *line, std::size_t length,
+                  MessageView &msg) noexcept;
+
+// Builds a validated, owning message from one line, for dispatch after the
+// receive buffer has been reused.
+bool parseIRCMessage(const char *line, std::size_t length, IRCMessage &token);
 
 #endif // !TOKEN_HPP
@@ -0,0 +1,160 @@
+#ifndef URINGBACKEND_HPP
+#define URINGBACKEND_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <linux/io_uring.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "./AcceptGuard.hpp"
+#include "./Config.hpp"
+#include "./EpollInterface.hpp"
+#include "./FileDescriptor.hpp"
+#include "./OutputBuffer.hpp"
+
+// io_uring engine: one multishot accept, a multishot recv per client fed
+// from a provided buffer ring, and sends that are queued while handling
+// completions and submitted together on the next io_uring_enter. Auxiliary
+// sockets and cross-thread wakeups go through a small epoll instance that
+// the ring polls.
+//
+// The kernel keeps filling a multishot recv for as long as data arrives, so
+// IRC_READ_BUDGET is applied to its completions: once a client was handed
+// its budget in one wait(), its recv is cancelled and the rest of what was
+// received waits for the next wait(), ahead of anything newer.
+class UringBackend final : public EpollInterface {
+  public:
+    explicit UringBackend(const Config &config);
+
+    UringBackend(const UringBackend &rhs) = delete;
+    UringBackend &operator=(const UringBackend &rhs) = delete;
+
+    UringBackend(UringBackend &&rhs) = delete;
+    UringBackend &operator=(UringBackend &&rhs) = delete;
+
+    ~UringBackend() override;
+
+  public:
+    bool init(int listenFD) override;
+    int wait(IOHandler &handler, int timeout) override;
+    const char *getName() const noexcept override;
+    IOStats getStats() const noexcept override;
+
+  public:
+    bool addClient(ClientHandle client) override;
+    void removeClient(int fd) override;
+    FlushResult flush(Client &client) override;
+    void pauseRecv(int fd, bool paused) override;
+    void deferAccept(bool deferred) override;
+    void flushPending(IOHandler &handler) override;
+
+  public:
+    void notifyEpollUpdate(ClientHandle client) override;
+    int getEpollFD() const noexcept override;
+
+  private:
+    // Everything a SENDMSG needs until its completion is reaped. The bytes
+    // are taken out of the client's queue, so the kernel never reads memory
+    // the client could free by disconnecting mid-send.
+    static constexpr std::size_t IOV_BATCH = 256;
+    struct PendingSend {
+        OutputBuffer out;
+        msghdr msg;
+        iovec iov[IOV_BATCH];
+    };
+
+    struct Slot {
+        std::uint32_t gen{0}; // 24 bits, as carried in user_data
+        std::uint32_t client{0}; // the slab's generation, see addClient
+        bool sending{false};
+        bool receiving{false}; // multishot recv armed
+        bool paused{false};    // leave it unarmed, see pauseRecv
+        bool throttled{false}; // over its read budget, see _completeRecv
+        std::uint32_t pass{0}; // the wait() that `received` counts for
+        std::size_t received{0};
+        std::size_t deferred{0}; // completions in _deferred
+        std::unique_ptr<PendingSend> carry; // taken, but not yet sent
+    };
+
+  private:
+    bool _setupRing() noexcept;
+    bool _setupBuffers() noexcept;
+    io_uring_sqe *_getSqe() noexcept;
+    int _enter(unsigned minComplete, int timeout) noexcept;
+    Slot &_slot(int fd);
+    ClientHandle _handle(int fd);
+    std::unique_ptr<PendingSend> _takeSend();
+    void _poolSend(std::unique_ptr<PendingSend> send) noexcept;
+
+  private:
+    void _armAccept() noexcept;
+    void _armRecv(int fd) noexcept;
+    void _cancelRecv(int fd) noexcept;
+    void _armPoll() noexcept;
+    void _recycleBuffer(std::uint16_t bid) noexcept;
+
+  private:
+    void _complete(IOHandler &handler, const io_uring_cqe &cqe);
+    void _completeRecv(IOHandler &handler, const io_uring_cqe &cqe);
+    void _completeSend(IOHandler &handler, const io_uring_cqe &cqe);
+    int _completeDeferred(IOHandler &handler);
+    void _drainAux(IOHandler &handler);
+
+  private:
+    FileDescriptor _ring_fd;
+    FileDescriptor _aux_fd;
+    FileDescriptor _wake_fd;
+    int _listen_fd{-1};
+    AcceptGuard _accept_guard;
+    bool _accept_paused{false}; // out of fds with nothing left to shed
+    bool _accept_wake{false};
+    bool _accept_deferred{false}; // see deferAccept
+    bool _accept_armed{false};    // until its final completion
+    std::size_t _read_budget;
+    std::uint32_t _pass{0}; // wait() calls so far
+
+  private:
+    void *_sq_ptr{nullptr};
+    std::size_t _sq_size{0};
+    void *_cq_ptr{nullptr};
+    std::size_t _cq_size{0};
+    io_uring_sqe *_sqes{nullptr};
+    std::size_t _sqes_size{0};
+    unsigned *_sq_head{nullptr};
+    unsigned *_sq_tail{nullptr};
+    unsigned *_sq_array{nullptr};
+    unsigned _sq_mask{0};
+    unsigned _sq_entries{0};
+    unsigned _sq_local_tail{0};
+    unsigned _sq_pending{0};
+    unsigned *_cq_head{nullptr};
+    unsigned *_cq_tail{nullptr};
+    unsigned _cq_mask{0};
+    io_uring_cqe *_cqes{nullptr};
+
+  private:
+    io_uring_buf *_buf_ring{nullptr};
+    std::size_t _buf_ring_size{0};
+    std::uint16_t _buf_tail{0};
+    std::vector<char> _buffers;
+
+  private:
+    std::vector<Slot> _slots;
+    std::unordered_map<std::uint64_t, std::unique_ptr<PendingSend>> _sends;
+    std::vector<std::unique_ptr<PendingSend>> _send_pool;
+    std::vector<io_uring_cqe> _deferred; // recvs over budget, in order
+    std::vector<io_uring_cqe> _replay;   // _deferred, being handed over
+
+  private:
+    std::mutex _mailbox_mutex;
+    std::vector<ClientHandle> _mailbox;
+    std::vector<ClientHandle> _ready;
+};
+
+#endif // !URINGBACKEND_HPP
@@ -5,6 +5,8 @@
 #include <memory>
 #include <string>
 
+#include <sys/uio.h>
+
 #include "../include/Client.hpp"
 #include "../include/Enums.hpp"
 
@@ -19,11 +21,20 @@ std::size_t toSizeT(const std::string &str);
 template <typename... Args>
 std::string formatMessage(const Args &...args) noexcept;
 
-void handleMsg(IRCCode code, const std::shared_ptr<Client> &client,
+void handleMsg(IRCCode code, Client *client,
                const std::string &value, const std::string &msg) noexcept;
 
+// Lines relayed from one client to others (JOIN, PRIVMSG, QUIT, ...), which
+// read the same for every recipient; empty for any other code.
+std::string formatRelay(IRCCode code, const std::string &prefix,
+                        const std::string &msg) noexcept;
+
 std::vector<std::string> split(const std::string &str,
                                const std::string &delim);
+
+// One TRACE record of the bytes about to be sent; callers check
+// Logger::enabled() first, as the record is built even if disabled.
+void logSend(int fd, const iovec *iov, std::size_t count) noexcept;
 #include "../templates/Utils.tpp"
 
 #endif // UTILS_HPP
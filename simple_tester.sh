@@ -1,7 +1,9 @@
 #!/bin/bash
 
-# Usage: ./simple_tester.sh <port> <password>
-# Simple tester that reconnects after every failed registration or command
+# Usage: ./simple_tester.sh <port> <password> [backend]
+# Simple tester that reconnects after every failed registration or command.
+# Given a backend (epoll, io_uring or uring), it starts ./ircserv on <port>
+# with IRC_BACKEND set to it and stops the server when done.
 
 if [ "$(uname)" = "Darwin" ]; then
     IRC_SERVER=$(ifconfig | grep "inet " | grep 127.0.0.1 | awk '{print $2}')
@@ -11,6 +13,7 @@ fi
 
 PORT="$1"
 PASSWORD="$2"
+BACKEND="$3"
 NICK="luuk"
 USER1="hello"
 CHANNEL="#nc"
@@ -45,6 +48,50 @@ run_raw_test() {
     sleep 1
 }
 
+# Pipes 200 JOINs in one go and hangs up before they are all handled. Start
+# the server with IRC_DISPATCH_BUDGET=1 so most of them are still held when
+# the hangup is seen; none of those may run for the closed client.
+run_held_test() {
+    {
+        register
+        for i in $(seq 0 199); do
+            echo "JOIN #held$i"
+        done
+    } | nc -C -N "$IRC_SERVER" "$PORT" > /dev/null
+    sleep 1
+}
+
+# A second client shares two channels with $NICK and prints how many QUIT
+# lines it got for $NICK's one QUIT
+run_quit_test() {
+    (sleep 1 && run_test "JOIN #q1,#q2") &
+    local quitter=$!
+    local quits
+    quits=$({
+        echo "PASS $PASSWORD"
+        echo "NICK watcher"
+        echo "USER watcher * $IRC_SERVER :watcher"
+        echo "JOIN #q1,#q2"
+        sleep 4
+        echo "QUIT :Leaving"
+    } | nc -C "$IRC_SERVER" "$PORT" | grep -c "^:$NICK!.* QUIT ")
+    wait "$quitter"
+    echo "QUIT lines for $NICK seen by watcher: $quits (expected 1)"
+}
+
+stop_server() {
+    kill -INT "$SERVER_PID" 2> /dev/null
+    wait "$SERVER_PID" 2> /dev/null
+}
+
+if [ -n "$BACKEND" ]; then
+    IRC_BACKEND="$BACKEND" "$(dirname "$0")/ircserv" "$PORT" "$PASSWORD" \
+        > /dev/null &
+    SERVER_PID=$!
+    trap stop_server EXIT
+    sleep 0.5
+fi
+
 ### Start tests
 
 # Bad registration (invalid PASS), expect disconnect
@@ -81,3 +128,16 @@ run_test "PRIVMSG"
 run_test "INVITE"
 run_test "USERHOST"
 run_test "WHOIS"
+
+# An emptied invite-only channel lingers without +i: the rejoin must not be
+# answered with 473
+run_test "JOIN #inv" "MODE #inv +i" "MODE #inv +k key" "PART #inv"
+run_test "JOIN #inv key" "MODE #inv"
+
+# One QUIT on two shared channels reaches the other member once
+run_quit_test
+
+# Disconnect with held commands: the next client on that fd must not be
+# listed in any #held channel, let alone as an operator
+run_held_test
+run_test "PRIVMSG BOT :channels"
@@ -0,0 +1,64 @@
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../include/AcceptGuard.hpp"
+#include "../include/Logger.hpp"
+
+AcceptGuard::AcceptGuard() : _spare(-1) {
+}
+
+bool AcceptGuard::reserve() noexcept {
+    if (0 <= _spare.get()) {
+        return true;
+    }
+
+    _spare = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    if (0 > _spare.get()) {
+        IRC_LOG(WARN) << "Failed to reserve spare fd: " << strerror(errno);
+        return false;
+    }
+
+    return true;
+}
+
+bool AcceptGuard::shed(const int listenFD) noexcept {
+    _failed.fetch_add(1, std::memory_order_relaxed);
+    if (0 > _spare.get()) {
+        reserve();
+        return false;
+    }
+
+    _spare.clos();
+    const int fd = accept(listenFD, nullptr, nullptr);
+    if (0 > fd) {
+        reserve();
+        return false;
+    }
+
+    close(fd);
+    _shed.fetch_add(1, std::memory_order_relaxed);
+    reserve();
+
+    IRC_LOG(WARN) << "Out of file descriptors, dropped a pending connection";
+    return true;
+}
+
+void AcceptGuard::accepted() noexcept {
+    _accepted.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AcceptGuard::failed() noexcept {
+    _failed.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AcceptGuard::fillStats(IOStats &stats) const noexcept {
+    stats.accepted = _accepted.load(std::memory_order_relaxed);
+    stats.acceptFailed = _failed.load(std::memory_order_relaxed);
+    stats.acceptShed = _shed.load(std::memory_order_relaxed);
+}
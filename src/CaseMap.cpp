@@ -0,0 +1,44 @@
+#include <cstddef>
+#include <string>
+
+#include "../include/CaseMap.hpp"
+
+// 'A'..'^' fold onto 'a'..'~', which covers both the letters and []\^.
+char ircFold(const char c) noexcept {
+    if (c >= 'A' && c <= '^') {
+        return static_cast<char>(c + ('a' - 'A'));
+    }
+
+    return c;
+}
+
+bool ircEquals(const std::string &lhs, const std::string &rhs) noexcept {
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+
+    for (std::size_t i = 0; i < lhs.size(); ++i) {
+        if (ircFold(lhs[i]) != ircFold(rhs[i])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// FNV-1a over the folded bytes.
+std::size_t CaseFoldHash::operator()(const std::string &key) const noexcept {
+    std::size_t hash = 14695981039346656037ULL;
+
+    for (const char c : key) {
+        hash ^= static_cast<unsigned char>(ircFold(c));
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+bool CaseFoldEqual::operator()(const std::string &lhs,
+                               const std::string &rhs) const noexcept {
+    return ircEquals(lhs, rhs);
+}
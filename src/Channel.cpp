@@ -1,17 +1,39 @@
-#include <algorithm>
 #include <cerrno>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "../include/Channel.hpp"
 #include "../include/Client.hpp"
 #include "../include/Enums.hpp"
+#include "../include/OutputBuffer.hpp"
 #include "../include/Utils.hpp"
 
-Channel::Channel(std::string name, std::string topic,
-                 const std::shared_ptr<Client> &client)
+namespace {
+// Blocks of freed channels, up to Defaults::CHANNEL_POOL of them. Reserved
+// up front so giving one back never allocates. Never destroyed: channels
+// may still be released during static destruction.
+struct ChannelPool {
+    std::mutex mutex;
+    std::vector<void *> blocks;
+};
+
+ChannelPool &channelPool() {
+    static ChannelPool *instance = []() {
+        ChannelPool *pool = new ChannelPool();
+        pool->blocks.reserve(getDefaultValue(Defaults::CHANNEL_POOL));
+        return pool;
+    }();
+    return *instance;
+}
+} // namespace
+
+Channel::Channel(std::string name, std::string topic, Client *client)
     : _name(std::move(name)), _topic(std::move(topic)), _password(""),
       _userLimit(getDefaultValue(Defaults::USERLIMIT)), _modes(0) {
     addUser(_password, client);
@@ -21,8 +43,9 @@ Channel::Channel(std::string name, std::string topic,
 Channel::Channel(Channel &&rhs) noexcept
     : _name(std::move(rhs._name)), _topic(std::move(rhs._topic)),
       _password(std::move(rhs._password)), _userLimit(rhs._userLimit),
-      _modes(rhs._modes), _users(std::move(rhs._users)),
-      _operators(std::move(rhs._operators)), _invites(std::move(rhs._invites)) {
+      _modes(rhs._modes), _emptiedAt(rhs._emptiedAt),
+      _members(std::move(rhs._members)) {
+    _relinkAll();
 }
 
 Channel &Channel::operator=(Channel &&rhs) noexcept {
@@ -32,16 +55,51 @@ Channel &Channel::operator=(Channel &&rhs) noexcept {
         _password = std::move(rhs._password);
         _userLimit = rhs._userLimit;
         _modes = rhs._modes;
-        _users = std::move(rhs._users);
-        _operators = std::move(rhs._operators);
-        _invites = std::move(rhs._invites);
+        _emptiedAt = rhs._emptiedAt;
+        _unlinkAll();
+        _members = std::move(rhs._members);
+        _relinkAll();
     }
 
     return *this;
 }
 
-bool Channel::addUser(const std::string &password,
-                      const std::shared_ptr<Client> &user) {
+Channel::~Channel() {
+    _unlinkAll();
+}
+
+void *Channel::operator new(const std::size_t size) {
+    if (size == sizeof(Channel)) {
+        ChannelPool &pool = channelPool();
+        const std::lock_guard<std::mutex> lock(pool.mutex);
+        if (pool.blocks.empty() != true) {
+            void *block = pool.blocks.back();
+            pool.blocks.pop_back();
+            return block;
+        }
+    }
+
+    return ::operator new(size);
+}
+
+void Channel::operator delete(void *block, const std::size_t size) noexcept {
+    if (block == nullptr) {
+        return;
+    }
+
+    if (size == sizeof(Channel)) {
+        ChannelPool &pool = channelPool();
+        const std::lock_guard<std::mutex> lock(pool.mutex);
+        if (pool.blocks.size() < pool.blocks.capacity()) {
+            pool.blocks.push_back(block);
+            return;
+        }
+    }
+
+    ::operator delete(block);
+}
+
+bool Channel::addUser(const std::string &password, Client *user) {
 
     if (hasInvite() == true) {
         if (isInvited(user) != true) {
@@ -60,28 +118,34 @@ bool Channel::addUser(const std::string &password,
     return _addUser(user);
 }
 
-void Channel::removeUser(const std::shared_ptr<Client> &user,
-                         const std::string &reason) {
-    const auto it = std::find(_users.begin(), _users.end(), user);
-
-    if (it == _users.end()) {
+void Channel::removeUser(Client *user, const std::string &reason) {
+    if (userOnChannel(user) != true) {
         return handleMsg(IRCCode::USERNOTINCHANNEL, user, getName(),
                          user->getNickname());
     }
 
     broadcast(IRCCode::PART, user->getFullID(), reason);
-    _users.erase(user);
+    quitUser(user);
+}
+
+void Channel::quitUser(Client *user) {
+    if (userOnChannel(user) != true) {
+        return;
+    }
+
+    _unlink(user);
+    _members.clear(user, MemberFlag::JOINED);
     removeOperator(user);
 
+    // Nobody is left to invite anyone, so a lingering channel must not stay
+    // invite-only; its key, limit and topic lock are kept.
     if (getActiveUsers() == 0) {
-        if (hasInvite()) {
-            _modes.reset(0);
-        }
+        _modes.reset(0);
+        _members.dropInvites();
     }
 }
 
-void Channel::kickUser(const std::shared_ptr<Client> &target,
-                       const std::shared_ptr<Client> &client,
+void Channel::kickUser(Client *target, Client *client,
                        const std::string &reason) {
     if (isOperator(client) != true) {
         return handleMsg(IRCCode::CHANOPRIVSNEEDED, client, getName(), "");
@@ -102,27 +166,33 @@ void Channel::kickUser(const std::shared_ptr<Client> &target,
                      target->getNickname());
 }
 
-void Channel::inviteUser(const std::shared_ptr<Client> &user,
-                         const std::shared_ptr<Client> &client) {
+std::uint16_t Channel::inviteUser(Client *user, Client *client) {
     if (isOperator(client) != true) {
         handleMsg(IRCCode::CHANOPRIVSNEEDED, client, getName(), "");
-        return;
+        return 0;
     }
 
     if (user == client) {
-        return;
+        return 0;
     }
 
-    _invites.emplace_back(user);
+    if (userOnChannel(user) == true) {
+        handleMsg(IRCCode::USERONCHANNEL, client, user->getNickname(),
+                  getName());
+        return 0;
+    }
+
+    const std::uint16_t serial =
+        _members.invite(user, user->getHandle().generation);
     handleMsg(IRCCode::INVITING, client, user->getNickname(), getName());
     handleMsg(IRCCode::INVITENOTICE, user, user->getFullID(),
               " :You have been invited to " + getName() + " by " +
                   client->getNickname());
+    return serial;
 }
 
 void Channel::setMode(const ChannelMode mode, const bool state,
-                      const std::string &value,
-                      const std::shared_ptr<Client> &client) {
+                      const std::string &value, Client *client) {
     if (isOperator(client) != true) {
         return handleMsg(IRCCode::CHANOPRIVSNEEDED, client, getName(), "");
     }
@@ -156,14 +226,7 @@ void Channel::setMode(const ChannelMode mode, const bool state,
             _modes.reset(2);
             return setPassword("", client);
         case ChannelMode::OPERATOR:
-            for (const std::shared_ptr<Client> &user : _users) {
-                if (user->getNickname() == value) {
-                    if (state) {
-                        return addOperator(user);
-                    }
-                    return removeOperator(user);
-                }
-            }
+            // The nick in `value` is resolved by the caller, see setOperator.
             break;
         case ChannelMode::USER_LIMIT:
             if (state) {
@@ -195,8 +258,7 @@ void Channel::setMode(const ChannelMode mode, const bool state,
     }
 }
 
-void Channel::setPassword(const std::string &password,
-                          const std::shared_ptr<Client> &client) {
+void Channel::setPassword(const std::string &password, Client *client) {
     if (isOperator(client) != true) {
         return handleMsg(IRCCode::CHANOPRIVSNEEDED, client, getName(), "");
     }
@@ -204,8 +266,7 @@ void Channel::setPassword(const std::string &password,
     _password = password;
 }
 
-void Channel::setUserLimit(const std::size_t limit,
-                           const std::shared_ptr<Client> &client) {
+void Channel::setUserLimit(const std::size_t limit, Client *client) {
     if (isOperator(client) != true) {
         return handleMsg(IRCCode::CHANOPRIVSNEEDED, client, getName(), "");
     }
@@ -213,8 +274,24 @@ void Channel::setUserLimit(const std::size_t limit,
     _userLimit = limit;
 }
 
-void Channel::setTopic(const std::string &topic,
-                       const std::shared_ptr<Client> &client) {
+void Channel::setOperator(const bool state, Client *target,
+                          Client *client) {
+    if (isOperator(client) != true) {
+        return handleMsg(IRCCode::CHANOPRIVSNEEDED, client, getName(), "");
+    }
+
+    if (target == nullptr || userOnChannel(target) != true) {
+        return;
+    }
+
+    if (state) {
+        return addOperator(target);
+    }
+
+    return removeOperator(target);
+}
+
+void Channel::setTopic(const std::string &topic, Client *client) {
     if (_hasTopic() && isOperator(client) != true) {
         return handleMsg(IRCCode::CHANOPRIVSNEEDED, client, getName(), "");
     }
@@ -224,24 +301,20 @@ void Channel::setTopic(const std::string &topic,
     broadcast(IRCCode::TOPIC, "", topic);
 }
 
-void Channel::addOperator(const std::shared_ptr<Client> &user) {
-    const auto it = std::find(_operators.begin(), _operators.end(), user);
-
-    if (it == _operators.end()) {
-        _operators.emplace(user);
+void Channel::addOperator(Client *user) {
+    if (isOperator(user) != true) {
+        _members.set(user, MemberFlag::OPERATOR);
         broadcast(IRCCode::MODE, serverName, "+o " + user->getNickname());
     }
 }
 
-void Channel::removeOperator(const std::shared_ptr<Client> &user) {
-    const auto it = std::find(_operators.begin(), _operators.end(), user);
-
-    if (it != _operators.end()) {
-        _operators.erase(user);
+void Channel::removeOperator(Client *user) {
+    if (isOperator(user)) {
+        _members.clear(user, MemberFlag::OPERATOR);
         broadcast(IRCCode::MODE, serverName, "-o " + user->getNickname());
 
-        if (!_users.empty() && _operators.empty()) {
-            addOperator(*_users.begin());
+        if (_members.joined() != 0 && _members.operators() == 0) {
+            addOperator(_members.begin()->client);
         }
     }
 }
@@ -255,7 +328,11 @@ const std::string &Channel::getTopic() const noexcept {
 }
 
 std::size_t Channel::getActiveUsers() const noexcept {
-    return _users.size();
+    return _members.joined();
+}
+
+const MemberTable &Channel::getMembers() const noexcept {
+    return _members;
 }
 
 std::string Channel::getChannelModes() const noexcept {
@@ -303,25 +380,38 @@ std::string Channel::getChannelModesValues() const noexcept {
 }
 
 void Channel::broadcast(const IRCCode code, const std::string &senderPrefix,
-                        const std::string &message) const {
-    for (const std::shared_ptr<Client> &user : _users) {
-        if (code == IRCCode::PRIVMSG &&
-            senderPrefix.find(user->getFullID()) != std::string::npos) {
+                        const std::string &message,
+                        const Client *except) const {
+    const std::string body =
+        code == IRCCode::NICKCHANGED ? message : getName() + " " + message;
+
+    // Relayed lines read the same for every member, so they are formatted
+    // once and shared; numerics such as TOPIC carry each member's nick.
+    const Payload payload = makePayload(formatRelay(code, senderPrefix, body));
+    for (const Member &member : _members) {
+        Client *user = member.client;
+        if (user == except) {
             continue;
         }
 
-        if (code == IRCCode::NICKCHANGED) {
-            handleMsg(code, user, senderPrefix, message);
+        if (payload->empty() != true) {
+            user->appendPayload(payload);
         } else {
-            handleMsg(code, user, senderPrefix, getName() + " " + message);
+            handleMsg(code, user, senderPrefix, body);
         }
     }
 }
 
 std::string Channel::getUserList() const noexcept {
     std::string userList;
-    for (const std::shared_ptr<Client> &user : _users) {
-        userList += (isOperator(user) ? "@" : "") + user->getNickname() + " ";
+    for (const Member &member : _members) {
+        const char *prefix = "";
+        if (member.has(MemberFlag::OPERATOR)) {
+            prefix = "@";
+        } else if (member.has(MemberFlag::VOICE)) {
+            prefix = "+";
+        }
+        userList += prefix + member.client->getNickname() + " ";
     }
 
     return userList;
@@ -343,45 +433,45 @@ bool Channel::hasInvite() const noexcept {
     return _modes.test(0);
 }
 
-bool Channel::isInvited(const std::shared_ptr<Client> &user) const noexcept {
-
-    if (std::find(_invites.begin(), _invites.end(), user) != _invites.end()) {
-        return true;
-    }
-    return false;
+bool Channel::isInvited(Client *user) const noexcept {
+    return _members.invited(user, user->getHandle().generation);
 }
 
-void Channel::removeFromInvited(const std::shared_ptr<Client> &user) noexcept {
-    _invites.erase(std::remove(_invites.begin(), _invites.end(), user),
-                   _invites.end());
+void Channel::removeFromInvited(Client *user) noexcept {
+    _members.clear(user, MemberFlag::INVITED);
 }
 
-bool Channel::_hasTopic() const noexcept {
-    return _modes.test(1);
+bool Channel::expireInvite(Client *user, const std::uint32_t generation,
+                           const std::uint16_t serial) noexcept {
+    return _members.expire(user, generation, serial);
 }
 
-bool Channel::isOperator(const std::shared_ptr<Client> &user) const noexcept {
-    const auto it = std::find(_operators.begin(), _operators.end(), user);
+bool Channel::hasPersistentModes() const noexcept {
+    return _hasTopic() || _hasPassword() || _hasUserLimit();
+}
 
-    if (it != _operators.end()) {
-        return true;
-    }
+void Channel::setEmptiedAt(
+    const std::chrono::steady_clock::time_point when) noexcept {
+    _emptiedAt = when;
+}
 
-    return false;
+std::chrono::steady_clock::time_point Channel::getEmptiedAt() const noexcept {
+    return _emptiedAt;
 }
 
-bool Channel::userOnChannel(
-    const std::shared_ptr<Client> &user) const noexcept {
-    const auto it = std::find(_users.begin(), _users.end(), user);
+bool Channel::_hasTopic() const noexcept {
+    return _modes.test(1);
+}
 
-    if (it == _users.end()) {
-        return false;
-    }
+bool Channel::isOperator(Client *user) const noexcept {
+    return _members.has(user, MemberFlag::OPERATOR);
+}
 
-    return true;
+bool Channel::userOnChannel(Client *user) const noexcept {
+    return _members.has(user, MemberFlag::JOINED);
 }
 
-bool Channel::_addUser(const std::shared_ptr<Client> &user) {
+bool Channel::_addUser(Client *user) {
     if (userOnChannel(user) == true) {
         handleMsg(IRCCode::USERONCHANNEL, user, getName(), "");
         return false;
@@ -392,7 +482,34 @@ bool Channel::_addUser(const std::shared_ptr<Client> &user) {
         return false;
     }
 
-    _users.emplace(user);
+    _members.set(user, MemberFlag::JOINED);
+    _members.setEdge(user, user->linkChannel(this));
     broadcast(IRCCode::JOIN, user->getFullID(), "");
     return true;
 }
+
+// Drops both ends of the user's membership edge; the edge the client moved
+// into the freed index belongs to another channel, which learns its new
+// position.
+void Channel::_unlink(Client *user) noexcept {
+    const std::uint32_t edge = _members.edge(user);
+    Channel *moved = user->unlinkChannel(edge);
+    if (moved != nullptr) {
+        moved->_members.setEdge(user, edge);
+    }
+}
+
+void Channel::_unlinkAll() noexcept {
+    while (_members.joined() != 0) {
+        Client *user = _members.begin()->client;
+        _unlink(user);
+        _members.clear(user, MemberFlag::JOINED);
+    }
+}
+
+// The clients' ends point at this object, which a move replaces.
+void Channel::_relinkAll() noexcept {
+    for (const Member &member : _members) {
+        member.client->relinkChannel(member.edge, this);
+    }
+}
@@ -1,11 +1,9 @@
 #include <algorithm>
 #include <cctype>
 #include <cerrno>
-#include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <exception>
-#include <iostream>
 #include <memory>
 #include <sstream>
 #include <stdexcept>
@@ -23,6 +21,7 @@
 #include "../include/Chatbot.hpp"
 #include "../include/Client.hpp"
 #include "../include/Enums.hpp"
+#include "../include/Logger.hpp"
 #include "../include/Server.hpp"
 #include "../include/Utils.hpp"
 
@@ -52,7 +51,7 @@ std::string findVal(const std::string &json, const std::string &key) {
                 return json.substr(value_start + 1,
                                    value_end - value_start - 1);
             } catch (const std::out_of_range &e) {
-                std::cerr << "Failed to substr: " << e.what() << '\n';
+                IRC_LOG(ERROR) << "Failed to substr: " << e.what();
                 return "Internal server error";
             }
         }
@@ -66,7 +65,7 @@ std::string findVal(const std::string &json, const std::string &key) {
         try {
             return json.substr(value_start, value_end - value_start);
         } catch (const std::out_of_range &e) {
-            std::cerr << "Failed to substr: " << e.what() << '\n';
+            IRC_LOG(ERROR) << "Failed to substr: " << e.what();
             return "Internal server error";
         }
     }
@@ -109,7 +108,7 @@ int getApiInfo(const char *hostname, const char *port) {
 
     const int addr = getaddrinfo(hostname, port, &hints, &res);
     if (addr != 0) {
-        std::cerr << "Could not resolve API hostname" << '\n';
+        IRC_LOG(WARN) << "Could not resolve API hostname";
         return -1;
     }
 
@@ -135,7 +134,7 @@ int getApiInfo(const char *hostname, const char *port) {
     freeaddrinfo(res);
 
     if (sockfd == -1) {
-        std::cerr << "Failed to create API connection socket" << '\n';
+        IRC_LOG(WARN) << "Failed to create API connection socket";
         return -1;
     }
 
@@ -208,7 +207,7 @@ ChatBot getChatCmd(const std::string &command) {
         try {
             uppercase_cmd = uppercase_cmd.substr(first, (last - first + 1));
         } catch (const std::out_of_range &e) {
-            std::cerr << "Failed to substr: " << e.what() << '\n';
+            IRC_LOG(ERROR) << "Failed to substr: " << e.what();
             return ChatBot::UNKNOWN;
         }
     }
@@ -219,7 +218,8 @@ ChatBot getChatCmd(const std::string &command) {
         {"HELLO", ChatBot::HELLO},       {"HI", ChatBot::HELLO},
         {"JOKE", ChatBot::JOKE},         {"HELP", ChatBot::HELP},
         {"QUOTE", ChatBot::QUOTE},       {"PING", ChatBot::PING},
-        {"CHANNELS", ChatBot::CHANNELS}, {"WEATHER", ChatBot::WEATHER}};
+        {"CHANNELS", ChatBot::CHANNELS}, {"WEATHER", ChatBot::WEATHER},
+        {"SENDQ", ChatBot::SENDQ},       {"LOAD", ChatBot::LOAD}};
 
     const auto it = commandMap.find(uppercase_cmd);
     if (it == commandMap.end()) {
@@ -244,8 +244,7 @@ ChatBot handleBotInput(const std::vector<std::string> &input) {
 
     return action;
 }
-std::string getWeatherDirectly(const std::string &location,
-                               const std::shared_ptr<Client> &client,
+std::string getWeatherDirectly(const std::string &location, Client *client,
                                Server *server) {
     const char *hostname = "api.weatherapi.com";
     const char *port = "80";
@@ -277,8 +276,8 @@ std::string getWeatherDirectly(const std::string &location,
     ev.data.fd = sockfd;
     epoll_ctl(server->getEpollFD(), EPOLL_CTL_ADD, sockfd, &ev);
 
-    const ApiRequest apiReq = {sockfd, client, "", request_ss.str(),
-                               ApiRequest::CONNECTING};
+    const ApiRequest apiReq = {sockfd, client->getHandle(), "",
+                               request_ss.str(), ApiRequest::CONNECTING};
     server->addApiRequest(apiReq);
 
     return "Fetching weather...";
@@ -286,11 +285,15 @@ std::string getWeatherDirectly(const std::string &location,
 } // namespace
 
 std::string handleBot(const std::vector<std::string> &params,
-                      const std::shared_ptr<Client> &client, Server *server) {
+                      Client *client, Server *server) {
     std::string response;
 
     const std::vector<std::string> input = split(params[1], " ");
     const ChatBot action = handleBotInput(input);
+    if (action != ChatBot::LOAD && server->isShedding()) {
+        return "The server is busy, try again later.";
+    }
+
     switch (action) {
         case ChatBot::HELLO:
             response = "Hello " + client->getNickname() + "!";
@@ -315,11 +318,17 @@ std::string handleBot(const std::vector<std::string> &params,
             break;
         case ChatBot::HELP:
             response = "Supported commands: hello, weather, joke, "
-                       "quote, ping, channels";
+                       "quote, ping, channels, sendq, load";
             break;
         case ChatBot::CHANNELS:
             response = server->getChannelsAndUsers();
             break;
+        case ChatBot::SENDQ:
+            response = server->getSendQStats();
+            break;
+        case ChatBot::LOAD:
+            response = server->getLoadStats();
+            break;
         case ChatBot::UNKNOWN:
             response = "Command unknown. Type 'help' to discover my functions.";
             break;
@@ -339,7 +348,7 @@ bool isBot(const std::string &nickname) {
     return (false);
 }
 
-void botResponseNl(const std::shared_ptr<Client> &client,
+void botResponseNl(Client *client,
                    const std::string &response) {
     std::string line;
     std::istringstream stream(response);
@@ -350,8 +359,8 @@ void botResponseNl(const std::shared_ptr<Client> &client,
     }
 }
 
-bool handleSendApi(ApiRequest &api, const epoll_event event,
-                   const int epoll_fd) {
+bool handleSendApi(ApiRequest &api, Client *client,
+                   const epoll_event event, const int epoll_fd) {
     if (api.state == api.State::CONNECTING) {
         int error = 0;
         socklen_t len = sizeof(error);
@@ -370,10 +379,11 @@ bool handleSendApi(ApiRequest &api, const epoll_event event,
         new_ev.events = EPOLLIN;
         new_ev.data.fd = event.data.fd;
         if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, event.data.fd, &new_ev) == -1) {
-            std::perror("epoll_ctl mod failed in handleSendApi");
+            IRC_LOG(WARN) << "epoll_ctl mod failed in handleSendApi: "
+                          << strerror(errno);
             close(event.data.fd);
             api.fd = -1;
-            botResponseNl(api.client,
+            botResponseNl(client,
                           "Server error setting up API response listener.");
             return false;
         }
@@ -382,7 +392,7 @@ bool handleSendApi(ApiRequest &api, const epoll_event event,
     return true;
 }
 
-void handleRecvApi(ApiRequest &api) {
+void handleRecvApi(ApiRequest &api, Client *client) {
     char buf[4096] = {};
     ssize_t n = -1;
     bool connection_closed_by_peer = false;
@@ -398,8 +408,8 @@ void handleRecvApi(ApiRequest &api) {
             if (errno == EAGAIN || errno == EWOULDBLOCK) {
                 break;
             }
-            std::perror("recv error in handleRecvApi");
-            botResponseNl(api.client, "Error receiving data from API.");
+            IRC_LOG(WARN) << "recv error in handleRecvApi: " << strerror(errno);
+            botResponseNl(client, "Error receiving data from API.");
             if (api.fd != -1) {
                 close(api.fd);
             }
@@ -415,12 +425,12 @@ void handleRecvApi(ApiRequest &api) {
     const std::size_t header_end = api.buffer.find("\r\n\r\n");
     if (header_end == std::string::npos) {
         if (connection_closed_by_peer) {
-            std::cerr
+            IRC_LOG(WARN)
                 << "handleRecvApi (fd=" << api.fd
                 << "): Connection closed before finding headers. Buffer size: "
-                << api.buffer.length() << '\n';
+                << api.buffer.length();
             botResponseNl(
-                api.client,
+                client,
                 "Error: Incomplete response from API (connection closed).");
             close(api.fd);
             api.fd = -1;
@@ -430,9 +440,9 @@ void handleRecvApi(ApiRequest &api) {
         if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
             return;
         }
-        std::cerr << "handleRecvApi (fd=" << api.fd
-                  << "): Headers not found, unexpected state." << '\n';
-        botResponseNl(api.client,
+        IRC_LOG(WARN) << "handleRecvApi (fd=" << api.fd
+                      << "): Headers not found, unexpected state.";
+        botResponseNl(client,
                       "Error: Unexpected state receiving API response.");
         close(api.fd);
         api.fd = -1;
@@ -443,10 +453,9 @@ void handleRecvApi(ApiRequest &api) {
         const std::string status_line =
             api.buffer.substr(0, api.buffer.find("\r\n"));
         if (status_line.find("200 OK") == std::string::npos) {
-            std::cerr << "handleRecvApi (fd=" << api.fd
-                      << "): API request failed. Status: " << status_line
-                      << '\n';
-            botResponseNl(api.client,
+            IRC_LOG(WARN) << "handleRecvApi (fd=" << api.fd
+                          << "): API request failed. Status: " << status_line;
+            botResponseNl(client,
                           "API request failed. Status: " + status_line);
             close(api.fd);
             api.fd = -1;
@@ -457,7 +466,7 @@ void handleRecvApi(ApiRequest &api) {
         try {
             json_body = api.buffer.substr(header_end + 4);
         } catch (const std::out_of_range &e) {
-            std::cerr << "Failed to substr: " << e.what() << '\n';
+            IRC_LOG(ERROR) << "Failed to substr: " << e.what();
             close(api.fd);
             api.fd = -1;
             return;
@@ -465,11 +474,10 @@ void handleRecvApi(ApiRequest &api) {
 
         if (json_body.empty()) {
             if (connection_closed_by_peer) {
-                std::cerr << "handleRecvApi (fd=" << api.fd
-                          << "): API response body is empty after headers "
-                             "(connection closed)."
-                          << '\n';
-                botResponseNl(api.client,
+                IRC_LOG(WARN) << "handleRecvApi (fd=" << api.fd
+                              << "): API response body is empty after headers "
+                                 "(connection closed).";
+                botResponseNl(client,
                               "Error: Received empty response body from API.");
                 close(api.fd);
                 api.fd = -1;
@@ -480,10 +488,9 @@ void handleRecvApi(ApiRequest &api) {
                 return;
             }
 
-            std::cerr << "handleRecvApi (fd=" << api.fd
-                      << "): API response body is empty (unknown reason)."
-                      << '\n';
-            botResponseNl(api.client,
+            IRC_LOG(WARN) << "handleRecvApi (fd=" << api.fd
+                          << "): API response body is empty (unknown reason).";
+            botResponseNl(client,
                           "Error: Received empty response body from API.");
             close(api.fd);
             api.fd = -1;
@@ -491,23 +498,23 @@ void handleRecvApi(ApiRequest &api) {
         }
 
         const std::string response = extractWeather(json_body);
-        botResponseNl(api.client, response);
+        botResponseNl(client, response);
         close(api.fd);
         api.fd = -1;
         return;
     } catch (const std::out_of_range &e) {
-        std::cerr << "handleRecvApi (fd=" << api.fd
-                  << "): Failed to extract/parse API response parts: "
-                  << e.what() << '\n';
-        botResponseNl(api.client, "Error processing API response structure.");
+        IRC_LOG(ERROR) << "handleRecvApi (fd=" << api.fd
+                       << "): Failed to extract/parse API response parts: "
+                       << e.what();
+        botResponseNl(client, "Error processing API response structure.");
     } catch (const std::exception &e) {
-        std::cerr << "handleRecvApi (fd=" << api.fd
-                  << "): Error processing API response: " << e.what() << '\n';
-        botResponseNl(api.client, "Error processing API response.");
+        IRC_LOG(ERROR) << "handleRecvApi (fd=" << api.fd
+                       << "): Error processing API response: " << e.what();
+        botResponseNl(client, "Error processing API response.");
     }
 
-    std::cerr << "handleRecvApi: Closing API socket fd " << api.fd
-              << " (reached end of function unexpectedly)" << '\n';
+    IRC_LOG(WARN) << "handleRecvApi: Closing API socket fd " << api.fd
+                  << " (reached end of function unexpectedly)";
     close(api.fd);
     api.fd = -1;
 }
@@ -1,7 +1,8 @@
 #include <algorithm>
+#include <cstdint>
 #include <cstdlib>
-#include <iostream>
-#include <stdexcept>
+#include <limits>
+#include <mutex>
 #include <utility>
 #include <vector>
 
@@ -9,220 +10,468 @@
 #include "../include/Enums.hpp"
 #include "../include/EpollInterface.hpp"
 
-Client::Client(const int fd)
-    : _fd(fd), _username(""), _nickname(""), _ip("0.0.0.0"), _realname(""),
-      _partial_buffer(""), _event{} {
-    _event.data.fd = _fd.get();
-    _event.events = EPOLLIN | EPOLLOUT;
-    _channels.reserve(static_cast<std::size_t>(Defaults::EVENT_SIZE));
+// Keeps the per-connection budget documented in Client.hpp honest.
+static_assert(sizeof(Client) <= 256, "Client outgrew its idle budget");
+
+namespace {
+std::uint32_t saturate(const std::size_t bytes) noexcept {
+    const std::size_t most = std::numeric_limits<std::uint32_t>::max();
+    return static_cast<std::uint32_t>(std::min(bytes, most));
+}
+} // namespace
+
+Client::Client(const int fd, const std::uint32_t generation)
+    : _fd(fd), _generation(generation),
+      _input(getDefaultValue(Defaults::MAXMSGLEN)) {
+    setIP("0.0.0.0");
 }
 
 Client::Client(Client &&rhs) noexcept
-    : _epollNotifier(rhs._epollNotifier), _fd(std::move(rhs._fd)),
-      _username(std::move(rhs._username)), _nickname(std::move(rhs._nickname)),
-      _ip(std::move(rhs._ip)), _realname(std::move(rhs._realname)),
-      _partial_buffer(std::move(rhs._partial_buffer)),
-      _messages(std::move(rhs._messages)), _offset(rhs._offset),
-      _event(rhs._event), _registered(rhs._registered),
-      _disconnect(rhs._disconnect), _channels(std::move(rhs._channels)) {
+    : _fd(std::move(rhs._fd)), _generation(rhs._generation),
+      _reactor(rhs._reactor), _flags(rhs._flags),
+      _sendq_state(rhs._sendq_state), _flood_tokens(rhs._flood_tokens),
+      _flood_stamp(rhs._flood_stamp), _recv_paused(rhs._recv_paused),
+      _scheduled(rhs._scheduled), _idle(rhs._idle),
+      _epollNotifier(rhs._epollNotifier),
+      _output(std::move(rhs._output)), _inflight(rhs._inflight),
+      _sendq_peak(rhs._sendq_peak), _class(rhs._class),
+      _input(std::move(rhs._input)),
+      _nickname(std::move(rhs._nickname)),
+      _username(std::move(rhs._username)), _ip(std::move(rhs._ip)),
+      _realname(std::move(rhs._realname)), _prefix(std::move(rhs._prefix)),
+      _fanout(rhs._fanout), _sendq_dropped(rhs._sendq_dropped),
+      _timer(rhs._timer), _channels(std::move(rhs._channels)) {
     rhs._fd = -1;
 }
 
 Client &Client::operator=(Client &&rhs) noexcept {
     if (this != &rhs) {
-        _epollNotifier = rhs._epollNotifier;
         _fd = std::move(rhs._fd);
-        _username = std::move(rhs._username);
+        _generation = rhs._generation;
+        _reactor = rhs._reactor;
+        _flags = rhs._flags;
+        _sendq_state = rhs._sendq_state;
+        _flood_tokens = rhs._flood_tokens;
+        _flood_stamp = rhs._flood_stamp;
+        _recv_paused = rhs._recv_paused;
+        _scheduled = rhs._scheduled;
+        _idle = rhs._idle;
+        _epollNotifier = rhs._epollNotifier;
+        _output = std::move(rhs._output);
+        _inflight = rhs._inflight;
+        _sendq_peak = rhs._sendq_peak;
+        _class = rhs._class;
+        _input = std::move(rhs._input);
         _nickname = std::move(rhs._nickname);
-        _partial_buffer = std::move(rhs._partial_buffer);
+        _username = std::move(rhs._username);
         _ip = std::move(rhs._ip);
-        _event = rhs._event;
-        _messages = std::move(rhs._messages);
-        _offset = rhs._offset;
-        _disconnect = rhs._disconnect;
-        _channels = std::move(rhs._channels);
-        _registered = rhs._registered;
         _realname = std::move(rhs._realname);
+        _prefix = std::move(rhs._prefix);
+        _fanout = rhs._fanout;
+        _sendq_dropped = rhs._sendq_dropped;
+        _timer = rhs._timer;
+        _channels = std::move(rhs._channels);
     }
 
     return *this;
 }
 
-Client::~Client() {
-    removeAllChannels();
-}
+Client::~Client() = default;
 
 void Client::setEpollNotifier(EpollInterface *notifier) {
     _epollNotifier = notifier;
 }
 
+void Client::setReactor(const std::size_t reactor) noexcept {
+    _reactor = static_cast<std::uint32_t>(reactor);
+}
+
+std::size_t Client::getReactor() const noexcept {
+    return _reactor;
+}
+
+std::mutex &Client::getSendMutex() noexcept {
+    return _send_mutex;
+}
+
 int Client::getFD() const noexcept {
     return _fd.get();
 }
 
-epoll_event &Client::getEvent() noexcept {
-    return _event;
+ClientHandle Client::getHandle() const noexcept {
+    return ClientHandle{_fd.get(), _generation};
+}
+
+FileDescriptor Client::takeFD() noexcept {
+    return std::move(_fd);
 }
 
 bool Client::isRegistered() const noexcept {
-    return _registered.all();
+    return (_flags & REGISTERED) == REGISTERED;
 }
 
 void Client::setUsername(const std::string &username) noexcept {
     setUsernameBit();
-    _username = username;
+    _username = Interned(username);
+    _updatePrefix();
 }
 
 void Client::setRealname(const std::string &realname) noexcept {
-    _realname = realname;
+    _realname = Interned(realname);
 }
 
 void Client::setNickname(const std::string &nickname) noexcept {
     setNicknameBit();
-    _nickname = nickname;
+    _nickname = Interned(nickname);
+    _updatePrefix();
 }
 
 const std::string &Client::getUsername() const noexcept {
-    return _username;
+    return _username.str();
 }
 
 const std::string &Client::getRealname() const noexcept {
-    return _realname;
+    return _realname.str();
 }
 
 const std::string &Client::getNickname() const noexcept {
-    return _nickname;
+    return _nickname.str();
 }
 
 void Client::setUsernameBit() noexcept {
-    _registered.set(0);
+    _flags |= USERNAME_SET;
 }
 
 void Client::setNicknameBit() noexcept {
-    _registered.set(1);
+    _flags |= NICKNAME_SET;
 }
 
 void Client::setPasswordBit() noexcept {
-    _registered.set(2);
+    _flags |= PASSWORD_SET;
 }
 
 bool Client::getUsernameBit() const noexcept {
-    return _registered.test(0);
+    return (_flags & USERNAME_SET) != 0;
 }
 
 bool Client::getNicknameBit() const noexcept {
-    return _registered.test(1);
+    return (_flags & NICKNAME_SET) != 0;
 }
 
 bool Client::getPasswordBit() const noexcept {
-    return _registered.test(2);
+    return (_flags & PASSWORD_SET) != 0;
 }
 
-std::string Client::getFullID() const noexcept {
-    return getNickname() + "!" + getUsername() + "@" + getIP();
+const std::string &Client::getFullID() const noexcept {
+    return _prefix;
+}
+
+// Every line the client originates carries this prefix, so it is built
+// when the identity changes rather than once per message or recipient.
+void Client::_updatePrefix() {
+    _prefix.clear();
+    _prefix.reserve(getNickname().size() + getUsername().size() +
+                    getIP().size() + 2);
+    _prefix.append(getNickname()).append(1, '!');
+    _prefix.append(getUsername()).append(1, '@').append(getIP());
 }
 
 void Client::setIP(const std::string &ip) noexcept {
-    _ip = ip;
+    _ip = Interned(ip);
+    _updatePrefix();
 }
 const std::string &Client::getIP() const noexcept {
-    return _ip;
+    return _ip.str();
 }
 
-void Client::appendToBuffer(const std::string &data) noexcept {
-    _partial_buffer += data;
+LineBuffer &Client::getInput() noexcept {
+    return _input;
 }
 
-std::string Client::getAndClearBuffer() noexcept {
-    const std::size_t index = _partial_buffer.find("\r\n");
-    if (index == std::string::npos) {
-        return "";
+OutputBuffer &Client::getOutput() noexcept {
+    return _output;
+}
+
+bool Client::haveMessagesToSend() const noexcept {
+    if (_output.empty() != true) {
+        return true;
     }
 
-    std::string tmp;
-    if (index == _partial_buffer.length()) {
-        tmp = _partial_buffer;
-        _partial_buffer.clear();
-    } else {
-        try {
-            tmp = _partial_buffer.substr(0, index);
-            _partial_buffer.erase(0, index + 2);
-        } catch (const std::out_of_range &e) {
-            std::cerr << "Failed to substr or erase: " << e.what() << '\n';
-            return "";
-        }
+    return false;
+}
+
+// A queue that already holds bytes is either marked for the flush phase or
+// waiting on the socket, so only the first append after a drain notifies.
+void Client::appendMessageToQue(const std::string &msg) noexcept {
+    const std::lock_guard<std::mutex> lock(_send_mutex);
+    if (_admit(msg.size()) != true) {
+        return;
+    }
+
+    const bool wasEmpty = _output.empty();
+    _output.append(msg);
+    _queued();
+    if (wasEmpty && _epollNotifier) {
+        _epollNotifier->notifyEpollUpdate(getHandle());
+    }
+}
+
+void Client::appendPayload(const Payload &payload) noexcept {
+    const std::lock_guard<std::mutex> lock(_send_mutex);
+    if (_admit(payload->size()) != true) {
+        return;
     }
 
-    return tmp;
+    const bool wasEmpty = _output.empty();
+    _output.append(payload);
+    _queued();
+    if (wasEmpty && _epollNotifier) {
+        _epollNotifier->notifyEpollUpdate(getHandle());
+    }
 }
 
-bool Client::hasCompleteMessage() const noexcept {
-    return _partial_buffer.find("\r\n") != std::string::npos;
+void Client::setDisconnect() noexcept {
+    _flags |= DISCONNECT;
 }
 
-std::string Client::getMessage() noexcept {
-    return _messages.front();
+bool Client::isDisconnect() const noexcept {
+    return (_flags & DISCONNECT) != 0;
 }
 
-void Client::removeMessage() noexcept {
-    _messages.pop();
-    _offset = 0;
+void Client::setConnectionClass(const ConnectionClass *limits,
+                                const std::uint32_t now) noexcept {
+    {
+        const std::lock_guard<std::mutex> lock(_send_mutex);
+        _class = limits;
+    }
+
+    _flood_tokens = static_cast<std::uint16_t>(limits->floodBurst);
+    _flood_stamp = now;
 }
 
-bool Client::haveMessagesToSend() const noexcept {
-    if (_messages.empty() != true) {
+// Charges `cost` tokens if the bucket holds them. Nothing is charged on a
+// refusal, so the caller can try the same command again later.
+bool Client::spendTokens(const std::size_t cost,
+                         const std::uint32_t now) noexcept {
+    if (_class == nullptr || _class->floodRate == 0) {
         return true;
     }
 
-    return false;
+    _refill(now);
+    const std::size_t charge = std::min(cost, _class->floodBurst);
+    if (_flood_tokens < charge) {
+        return false;
+    }
+
+    _flood_tokens = static_cast<std::uint16_t>(_flood_tokens - charge);
+    return true;
 }
 
-void Client::appendMessageToQue(const std::string &msg) noexcept {
-    _messages.emplace(msg);
-    if (_epollNotifier) {
-        _epollNotifier->notifyEpollUpdate(_fd.get());
+// Milliseconds until spendTokens(cost, ...) can succeed, 0 if it can now.
+std::uint32_t Client::tokenDelay(const std::size_t cost,
+                                 const std::uint32_t now) const noexcept {
+    if (_class == nullptr || _class->floodRate == 0) {
+        return 0;
     }
+
+    const std::size_t charge = std::min(cost, _class->floodBurst);
+    const std::size_t elapsed = static_cast<std::uint32_t>(now - _flood_stamp);
+    const std::size_t have = std::min(
+        _class->floodBurst,
+        _flood_tokens + elapsed * _class->floodRate / 1000);
+    if (have >= charge) {
+        return 0;
+    }
+
+    const std::size_t wait = ((charge - have) * 1000 + _class->floodRate - 1) /
+                             _class->floodRate;
+    return saturate(wait);
 }
 
-void Client::setDisconnect() noexcept {
-    _disconnect = true;
+bool Client::setRecvPaused(const RecvPause reason, const bool paused) noexcept {
+    const bool was = _recv_paused != 0;
+    if (paused == true) {
+        _recv_paused |= reason;
+    } else {
+        _recv_paused = static_cast<std::uint8_t>(_recv_paused & ~reason);
+    }
+
+    return was != (_recv_paused != 0);
 }
 
-bool Client::isDisconnect() const noexcept {
-    return _disconnect;
+bool Client::isRecvPaused(const RecvPause reason) const noexcept {
+    return (_recv_paused & reason) != 0;
+}
+
+void Client::setScheduled(const bool scheduled) noexcept {
+    _scheduled = scheduled;
+}
+
+bool Client::isScheduled() const noexcept {
+    return _scheduled;
+}
+
+void Client::markHeard() noexcept {
+    _idle = static_cast<std::uint8_t>(_idle | IDLE_HEARD);
+}
+
+IdleAction Client::checkIdle() noexcept {
+    if ((_idle & IDLE_HEARD) != 0) {
+        _idle = 0;
+        return IdleAction::NONE;
+    }
+
+    if ((_idle & IDLE_PINGED) != 0) {
+        return IdleAction::TIMEOUT;
+    }
+
+    _idle = IDLE_PINGED;
+    return IdleAction::PING;
+}
+
+void Client::setTimer(const std::uint32_t timer) noexcept {
+    _timer = timer;
+}
+
+std::uint32_t Client::getTimer() const noexcept {
+    return _timer;
+}
+
+void Client::setInFlight(const std::size_t bytes) noexcept {
+    _inflight = saturate(bytes);
+}
+
+// Runs on the owning reactor after a flush. A full queue is acted on once
+// per episode; the episode ends when the queue has drained to half.
+SendQAction Client::checkSendQ() noexcept {
+    const std::lock_guard<std::mutex> lock(_send_mutex);
+    if (_class == nullptr) {
+        return SendQAction::NONE;
+    }
+
+    if ((_sendq_state & SENDQ_FULL) != 0) {
+        if (_class->sendqPolicy == SendQPolicy::DISCONNECT) {
+            return SendQAction::EVICT;
+        }
+
+        _sendq_state = static_cast<std::uint8_t>(_sendq_state & ~SENDQ_FULL);
+        if ((_sendq_state & SENDQ_THROTTLED) != 0) {
+            return SendQAction::NONE;
+        }
+
+        _sendq_state |= SENDQ_THROTTLED;
+        return _class->sendqPolicy == SendQPolicy::PAUSE ? SendQAction::PAUSE
+                                                         : SendQAction::DROP;
+    }
+
+    if ((_sendq_state & SENDQ_THROTTLED) != 0 &&
+        _output.size() + _inflight <= _class->sendq / 2) {
+        _sendq_state =
+            static_cast<std::uint8_t>(_sendq_state & ~SENDQ_THROTTLED);
+        return SendQAction::RESUME;
+    }
+
+    return SendQAction::NONE;
 }
 
-void Client::addChannel(const std::string &channelName) noexcept {
-    const auto it = std::find(_channels.begin(), _channels.end(), channelName);
+SendQStats Client::getSendQStats() noexcept {
+    const std::lock_guard<std::mutex> lock(_send_mutex);
+    return SendQStats{_output.size() + _inflight, _sendq_peak,
+                      _class == nullptr ? 0 : _class->sendq, _sendq_dropped};
+}
 
-    if (it == _channels.end()) {
-        _channels.emplace_back(channelName);
+// Under the send mutex, before an append of `bytes`. A refusal is counted
+// and, the first time since the last check, handed to the owning reactor.
+bool Client::_admit(const std::size_t bytes) noexcept {
+    if (_class == nullptr || _class->sendq == 0 ||
+        _output.size() + _inflight + bytes <= _class->sendq) {
+        return true;
+    }
+
+    ++_sendq_dropped;
+    if ((_sendq_state & SENDQ_FULL) == 0) {
+        _sendq_state |= SENDQ_FULL;
+        if (_epollNotifier) {
+            _epollNotifier->notifyEpollUpdate(getHandle());
+        }
     }
+
+    return false;
 }
-void Client::removeChannel(const std::string &channelName) noexcept {
-    const auto it = std::find(_channels.begin(), _channels.end(), channelName);
 
-    if (it != _channels.end()) {
-        _channels.erase(it);
+// Adds what the class's rate earned since _flood_stamp. The stamp only moves
+// by the time the added tokens account for, so no fraction is lost between
+// calls; a full bucket earns nothing and restarts it from `now`.
+void Client::_refill(const std::uint32_t now) noexcept {
+    const std::size_t elapsed = static_cast<std::uint32_t>(now - _flood_stamp);
+    const std::size_t room = _class->floodBurst - _flood_tokens;
+    const std::size_t added = elapsed * _class->floodRate / 1000;
+    if (added >= room) {
+        _flood_tokens = static_cast<std::uint16_t>(_class->floodBurst);
+        _flood_stamp = now;
+        return;
     }
+
+    _flood_tokens = static_cast<std::uint16_t>(_flood_tokens + added);
+    _flood_stamp += static_cast<std::uint32_t>(added * 1000 /
+                                               _class->floodRate);
 }
 
-void Client::removeAllChannels() noexcept {
-    const std::vector<std::string> channels = allChannels();
+void Client::_queued() noexcept {
+    _sendq_peak = std::max(_sendq_peak, saturate(_output.size() + _inflight));
+}
 
-    for (const std::string &channel : channels) {
-        removeChannel(channel);
+std::uint32_t Client::linkChannel(Channel *channel) {
+    if (_channels == nullptr) {
+        _channels.reset(new std::vector<Channel *>());
     }
+
+    _channels->push_back(channel);
+    return static_cast<std::uint32_t>(_channels->size() - 1);
 }
 
-const std::vector<std::string> &Client::allChannels() const noexcept {
-    return _channels;
+Channel *Client::unlinkChannel(const std::uint32_t edge) noexcept {
+    if (_channels == nullptr || edge >= _channels->size()) {
+        return nullptr;
+    }
+
+    Channel *moved = _channels->back();
+    _channels->pop_back();
+    if (edge == _channels->size()) {
+        moved = nullptr;
+    } else {
+        (*_channels)[edge] = moved;
+    }
+
+    if (_channels->empty()) {
+        _channels.reset();
+    }
+
+    return moved;
 }
 
-void Client::setOffset(const std::size_t offset) noexcept {
-    _offset += offset;
+void Client::relinkChannel(const std::uint32_t edge,
+                           Channel *channel) noexcept {
+    if (_channels != nullptr && edge < _channels->size()) {
+        (*_channels)[edge] = channel;
+    }
 }
 
-std::size_t Client::getOffset() const noexcept {
-    return _offset;
+const std::vector<Channel *> &Client::getChannels() const noexcept {
+    static const std::vector<Channel *> none;
+
+    if (_channels == nullptr) {
+        return none;
+    }
+
+    return *_channels;
+}
+
+bool Client::markFanout(const std::uint64_t epoch) noexcept {
+    if (_fanout == epoch) {
+        return false;
+    }
+
+    _fanout = epoch;
+    return true;
 }
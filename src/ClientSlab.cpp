@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+
+#include <sys/resource.h>
+
+#include "../include/Client.hpp"
+#include "../include/ClientSlab.hpp"
+#include "../include/FileDescriptor.hpp"
+
+namespace {
+// The slab is sized for every fd the process may open, capped so a huge
+// RLIMIT_NOFILE only costs chunk pointers, never chunks.
+constexpr std::size_t MAX_FDS = 1 << 20;
+
+std::size_t fdLimit() noexcept {
+    rlimit limit{};
+    if (0 > getrlimit(RLIMIT_NOFILE, &limit) ||
+        limit.rlim_cur == RLIM_INFINITY) {
+        return MAX_FDS;
+    }
+
+    return std::min(static_cast<std::size_t>(limit.rlim_cur), MAX_FDS);
+}
+} // namespace
+
+ClientSlab::ClientSlab()
+    : _capacity(fdLimit()),
+      _chunks(new std::atomic<Slot *>[(_capacity + CHUNK_SIZE - 1) /
+                                      CHUNK_SIZE]()) {
+}
+
+ClientSlab::ClientSlab(ClientSlab &&rhs) noexcept
+    : _capacity(rhs._capacity), _chunks(std::move(rhs._chunks)) {
+    rhs._capacity = 0;
+}
+
+ClientSlab &ClientSlab::operator=(ClientSlab &&rhs) noexcept {
+    if (this != &rhs) {
+        _release();
+        _capacity = rhs._capacity;
+        _chunks = std::move(rhs._chunks);
+        rhs._capacity = 0;
+    }
+
+    return *this;
+}
+
+ClientSlab::~ClientSlab() {
+    _release();
+}
+
+Client *ClientSlab::create(const int fd) {
+    if (0 > fd || static_cast<std::size_t>(fd) >= _capacity) {
+        return nullptr;
+    }
+
+    Slot &slot = _claim(fd);
+    if (slot.state.load(std::memory_order_acquire) != SlotState::FREE) {
+        _client(slot)->~Client();
+    }
+
+    ++slot.generation;
+    new (&slot.storage) Client(fd, slot.generation);
+    slot.state.store(SlotState::LIVE, std::memory_order_relaxed);
+
+    return _client(slot);
+}
+
+Client *ClientSlab::get(const int fd) const noexcept {
+    Slot *slot = _find(fd);
+    if (slot == nullptr || slot->state != SlotState::LIVE) {
+        return nullptr;
+    }
+
+    return _client(*slot);
+}
+
+Client *ClientSlab::get(const ClientHandle handle) const noexcept {
+    Slot *slot = _find(handle.fd);
+    if (slot == nullptr || slot->state != SlotState::LIVE ||
+        slot->generation != handle.generation) {
+        return nullptr;
+    }
+
+    return _client(*slot);
+}
+
+void ClientSlab::retire(const int fd) noexcept {
+    Slot *slot = _find(fd);
+    if (slot != nullptr && slot->state == SlotState::LIVE) {
+        slot->state = SlotState::RETIRED;
+    }
+}
+
+void ClientSlab::destroy(const int fd) noexcept {
+    Slot *slot = _find(fd);
+    if (slot != nullptr && slot->state != SlotState::FREE) {
+        const FileDescriptor closer = _client(*slot)->takeFD();
+        _client(*slot)->~Client();
+        slot->state.store(SlotState::FREE, std::memory_order_release);
+    }
+}
+
+std::size_t ClientSlab::capacity() const noexcept {
+    return _capacity;
+}
+
+ClientSlab::Slot *ClientSlab::_find(const int fd) const noexcept {
+    if (0 > fd || static_cast<std::size_t>(fd) >= _capacity) {
+        return nullptr;
+    }
+
+    const std::size_t index = static_cast<std::size_t>(fd);
+    Slot *chunk = _chunks[index / CHUNK_SIZE].load(std::memory_order_acquire);
+    if (chunk == nullptr) {
+        return nullptr;
+    }
+
+    return &chunk[index % CHUNK_SIZE];
+}
+
+ClientSlab::Slot &ClientSlab::_claim(const int fd) {
+    const std::size_t index = static_cast<std::size_t>(fd);
+    std::atomic<Slot *> &entry = _chunks[index / CHUNK_SIZE];
+
+    Slot *chunk = entry.load(std::memory_order_acquire);
+    if (chunk == nullptr) {
+        const std::lock_guard<std::mutex> lock(_grow_mutex);
+        chunk = entry.load(std::memory_order_relaxed);
+        if (chunk == nullptr) {
+            chunk = new Slot[CHUNK_SIZE]();
+            entry.store(chunk, std::memory_order_release);
+        }
+    }
+
+    return chunk[index % CHUNK_SIZE];
+}
+
+Client *ClientSlab::_client(Slot &slot) noexcept {
+    return reinterpret_cast<Client *>(&slot.storage);
+}
+
+void ClientSlab::_release() noexcept {
+    if (_chunks == nullptr) {
+        return;
+    }
+
+    const std::size_t chunks = (_capacity + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    for (std::size_t index = 0; index < chunks; ++index) {
+        Slot *chunk = _chunks[index].load(std::memory_order_relaxed);
+        if (chunk == nullptr) {
+            continue;
+        }
+
+        for (std::size_t offset = 0; offset < CHUNK_SIZE; ++offset) {
+            if (chunk[offset].state != SlotState::FREE) {
+                _client(chunk[offset])->~Client();
+            }
+        }
+        delete[] chunk;
+    }
+    _chunks.reset();
+}
@@ -6,11 +6,11 @@
 #include "../include/Token.hpp"
 #include "../include/Utils.hpp"
 
-void Server::_handleCommand(const IRCMessage &token,
-                            const std::shared_ptr<Client> &client) noexcept {
+void Server::_handleCommand(const IRCMessage &token, Client *client) noexcept {
 
     switch (token.type) {
         case IRCCommand::CAP:
+        case IRCCommand::PONG: // any line counts as alive, see _clientRecv
             break;
         case IRCCommand::NICK:
             if (!client->getPasswordBit()) {
@@ -51,7 +51,7 @@ void Server::_handleCommand(const IRCMessage &token,
             }
             return _handlePart(token, client);
         case IRCCommand::QUIT:
-            _removeClient(client);
+            _removeClient(client, token.params[0]);
             break;
         case IRCCommand::PING:
             if (!client->isRegistered()) {
@@ -1,7 +1,8 @@
 #include <algorithm>
 #include <cctype>
+#include <chrono>
 #include <cstddef>
-#include <iostream>
+#include <cstdint>
 #include <memory>
 #include <sstream>
 #include <string>
@@ -10,23 +11,15 @@
 #include "../include/Chatbot.hpp"
 #include "../include/Client.hpp"
 #include "../include/Enums.hpp"
+#include "../include/Logger.hpp"
 #include "../include/Server.hpp"
 #include "../include/Token.hpp"
 #include "../include/Utils.hpp"
 
-void Server::_handleNickname(const IRCMessage &token,
-                             const std::shared_ptr<Client> &client) noexcept {
-    std::string nickname = token.params[0];
-    std::transform(nickname.begin(), nickname.end(), nickname.begin(),
-                   ::toupper);
-
-    for (const auto &it : _nick_to_client) {
-        std::string uppercaseIt = it.first;
-        std::transform(uppercaseIt.begin(), uppercaseIt.end(),
-                       uppercaseIt.begin(), ::toupper);
-        if (uppercaseIt == nickname) {
-            return handleMsg(IRCCode::NICKINUSE, client, token.params[0], "");
-        }
+void Server::_handleNickname(const IRCMessage &token, Client *client) noexcept {
+    const auto inUse = _nick_to_client.find(token.params[0]);
+    if (inUse != _nick_to_client.end() && inUse->second != client) {
+        return handleMsg(IRCCode::NICKINUSE, client, token.params[0], "");
     }
 
     const bool wasRegistered = client->isRegistered();
@@ -38,19 +31,20 @@ void Server::_handleNickname(const IRCMessage &token,
         _clientAccepted(client);
     } else if (client->isRegistered()) {
         handleMsg(IRCCode::NICKCHANGED, client, old_id, client->getNickname());
-
-        for (const auto &it : _channels) {
-                it.second.broadcast(IRCCode::NICKCHANGED, old_id,
-                                     client->getNickname());
-        }
+        _sendToPeers(client,
+                     makePayload(formatRelay(IRCCode::NICKCHANGED, old_id,
+                                             client->getNickname())));
     }
 
+    // Erase first: a case-only change folds to the same key.
+    const auto old = _nick_to_client.find(old_nickname);
+    if (old != _nick_to_client.end() && old->second == client) {
+        _nick_to_client.erase(old);
+    }
     _nick_to_client[client->getNickname()] = client;
-    _nick_to_client.erase(old_nickname);
 }
 
-void Server::_handleUsername(const IRCMessage &token,
-                             const std::shared_ptr<Client> &client) noexcept {
+void Server::_handleUsername(const IRCMessage &token, Client *client) noexcept {
     if (client->isRegistered()) {
         handleMsg(IRCCode::ALREADYREGISTERED, client, "", "");
     } else {
@@ -60,9 +54,8 @@ void Server::_handleUsername(const IRCMessage &token,
     }
 }
 
-void Server::_handlePassword(
-    const IRCMessage &token,
-    const std::shared_ptr<Client> &client) const noexcept {
+void Server::_handlePassword(const IRCMessage &token,
+                             Client *client) const noexcept {
     if (client->isRegistered()) {
         handleMsg(IRCCode::ALREADYREGISTERED, client, "", "");
     } else {
@@ -75,8 +68,7 @@ void Server::_handlePassword(
     }
 }
 
-void Server::_handlePriv(const IRCMessage &token,
-                         const std::shared_ptr<Client> &client) noexcept {
+void Server::_handlePriv(const IRCMessage &token, Client *client) noexcept {
     if (token.params[1].empty()) {
         return handleMsg(IRCCode::NOTEXTTOSEND, client, client->getNickname(),
                          "");
@@ -108,7 +100,7 @@ void Server::_handlePriv(const IRCMessage &token,
             }
 
             channel->broadcast(IRCCode::PRIVMSG, client->getFullID(),
-                               ":" + token.params[1]);
+                               ":" + token.params[1], client);
         }
     } else if (bot == "BOT") {
         const std::string response = handleBot(token.params, client, this);
@@ -120,39 +112,30 @@ void Server::_handlePriv(const IRCMessage &token,
                       client->getNickname() + " :" + response);
         }
     } else {
-        std::string nickname = token.params[0];
-        std::transform(nickname.begin(), nickname.end(), nickname.begin(),
-                       ::toupper);
-
-        for (auto const &it : _nick_to_client) {
-            std::string upperCaseIt = it.second->getNickname();
-            std::transform(upperCaseIt.begin(), upperCaseIt.end(),
-                           upperCaseIt.begin(), ::toupper);
-            if (upperCaseIt == nickname) {
-                return handleMsg(
-                    IRCCode::PRIVMSG, it.second, client->getFullID(),
-                    client->getNickname() + " :" + token.params[1]);
-            }
+        const auto it = _nick_to_client.find(token.params[0]);
+        if (it != _nick_to_client.end()) {
+            return handleMsg(IRCCode::PRIVMSG, it->second, client->getFullID(),
+                             client->getNickname() + " :" + token.params[1]);
         }
         return handleMsg(IRCCode::NOSUCHNICK, client, token.params[0], "");
     }
 }
 
-void Server::_handleJoin(const IRCMessage &token,
-                         const std::shared_ptr<Client> &client) noexcept {
+void Server::_handleJoin(const IRCMessage &token, Client *client) noexcept {
     for (std::size_t index = 0; index < token.params.size(); ++index) {
         const std::string &channelName = token.params[index];
 
         Channel *channel = isChannel(channelName);
         if (channel == nullptr) {
             const auto emplace_result = _channels.emplace(
-                channelName, Channel(channelName, "Default", client));
+                channelName, std::unique_ptr<Channel>(
+                                 new Channel(channelName, "Default", client)));
             if (!emplace_result.second) {
                 handleMsg(IRCCode::NOSUCHCHANNEL, client, channelName, "");
                 continue;
             }
 
-            channel = &(emplace_result.first->second);
+            channel = emplace_result.first->second.get();
         } else {
             const std::string &password =
                 index < token.keys.size() ? token.keys[index] : "";
@@ -161,27 +144,16 @@ void Server::_handleJoin(const IRCMessage &token,
             }
         }
 
-        if (channel->hasInvite()) {
-            if (!channel->isInvited(client)) {
-                handleMsg(IRCCode::INVITEONLYCHAN, client, channel->getName(),
-                          "");
-
-                continue;
-            }
-        }
-
         handleMsg(IRCCode::TOPIC, client, channel->getName(),
                   channel->getTopic());
         handleMsg(IRCCode::NAMREPLY, client, channel->getName(),
                   channel->getUserList());
         handleMsg(IRCCode::ENDOFNAMES, client, channel->getName(), "");
-        client->addChannel(channel->getName());
         channel->removeFromInvited(client);
     }
 }
 
-void Server::_handleTopic(const IRCMessage &token,
-                          const std::shared_ptr<Client> &client) noexcept {
+void Server::_handleTopic(const IRCMessage &token, Client *client) noexcept {
     const std::string channelName = token.params[0];
 
     Channel *channel = isChannel(channelName);
@@ -198,8 +170,7 @@ void Server::_handleTopic(const IRCMessage &token,
     channel->setTopic(token.params[1], client);
 }
 
-void Server::_handlePart(const IRCMessage &token,
-                         const std::shared_ptr<Client> &client) noexcept {
+void Server::_handlePart(const IRCMessage &token, Client *client) noexcept {
     for (const std::string &channelName : token.params) {
         Channel *channel = isChannel(channelName);
 
@@ -207,18 +178,20 @@ void Server::_handlePart(const IRCMessage &token,
             return handleMsg(IRCCode::NOSUCHCHANNEL, client, channelName, "");
         }
 
+        const bool joined = channel->userOnChannel(client);
         channel->removeUser(client, token.reason);
+        if (joined == true) {
+            _releaseIfEmpty(channel);
+        }
     }
 }
 
-void Server::_handlePing(const IRCMessage &token,
-                         const std::shared_ptr<Client> &client) noexcept {
+void Server::_handlePing(const IRCMessage &token, Client *client) noexcept {
     client->appendMessageToQue(formatMessage(
         ":", serverName, " PONG ", serverName, " :" + token.params[0]));
 }
 
-void Server::_handleKick(const IRCMessage &token,
-                         const std::shared_ptr<Client> &client) noexcept {
+void Server::_handleKick(const IRCMessage &token, Client *client) noexcept {
     for (const std::string &channelName : token.params) {
 
         Channel *channel = isChannel(channelName);
@@ -227,66 +200,41 @@ void Server::_handleKick(const IRCMessage &token,
             continue;
         }
 
-        std::shared_ptr<Client> targetClient = nullptr;
         for (const std::string &username : token.keys) {
-            std::string upperUserNickToKick = username;
-            std::transform(upperUserNickToKick.begin(),
-                           upperUserNickToKick.end(),
-                           upperUserNickToKick.begin(), ::toupper);
-
-            for (const auto &pair : _nick_to_client) {
-                std::string currentNickUpper = pair.first;
-                std::transform(currentNickUpper.begin(), currentNickUpper.end(),
-                               currentNickUpper.begin(), ::toupper);
-                if (currentNickUpper == upperUserNickToKick) {
-                    targetClient = pair.second;
-                    break;
-                }
-            }
-
-            if (targetClient == nullptr) {
+            const auto target = _nick_to_client.find(username);
+            if (target == _nick_to_client.end()) {
                 handleMsg(IRCCode::NOSUCHNICK, client, username, "");
                 continue;
             }
 
-            channel->kickUser(targetClient, client, token.reason);
+            channel->kickUser(target->second, client, token.reason);
         }
     }
 }
 
-void Server::_handleInvite(const IRCMessage &token,
-                           const std::shared_ptr<Client> &client) noexcept {
+void Server::_handleInvite(const IRCMessage &token, Client *client) noexcept {
     const std::string channelName = token.params[1];
 
-    std::shared_ptr<Client> targetClient = nullptr;
     Channel *channel = isChannel(channelName);
     if (channel == nullptr) {
         return handleMsg(IRCCode::NOSUCHCHANNEL, client, token.params[1], "");
     }
 
-    std::string nickname = token.params[0];
-    std::transform(nickname.begin(), nickname.end(), nickname.begin(),
-                   ::toupper);
-
-    for (auto const &it : _nick_to_client) {
-        std::string upperCaseIt = it.second->getNickname();
-        std::transform(upperCaseIt.begin(), upperCaseIt.end(),
-                       upperCaseIt.begin(), ::toupper);
-        if (upperCaseIt == nickname) {
-            targetClient = it.second;
-            break;
-        }
-    }
-
-    if (targetClient == nullptr) {
+    const auto target = _nick_to_client.find(token.params[0]);
+    if (target == _nick_to_client.end()) {
         return handleMsg(IRCCode::NOSUCHNICK, client, token.params[0], "");
     }
 
-    channel->inviteUser(targetClient, client);
+    Client *const user = target->second;
+    const std::uint16_t serial = channel->inviteUser(user, client);
+    if (serial != 0 && _config.inviteTimeout != 0) {
+        _invites.arm(std::chrono::seconds(_config.inviteTimeout),
+                     Invite{channel->getName(), user,
+                            user->getHandle().generation, serial});
+    }
 }
 
-void Server::_handleMode(const IRCMessage &token,
-                         const std::shared_ptr<Client> &client) noexcept {
+void Server::_handleMode(const IRCMessage &token, Client *client) noexcept {
     const std::string channelName = token.params[0];
 
     Channel *channel = isChannel(channelName);
@@ -316,9 +264,15 @@ void Server::_handleMode(const IRCMessage &token,
             channel->setMode(ChannelMode::PASSWORD_PROTECTED, state, value,
                              client);
             break;
-        case ChannelCommand::MODE_O:
-            channel->setMode(ChannelMode::OPERATOR, state, value, client);
+        case ChannelCommand::MODE_O: {
+            const auto target = _nick_to_client.find(value);
+            channel->setOperator(state,
+                                 target != _nick_to_client.end()
+                                     ? target->second
+                                     : nullptr,
+                                 client);
             break;
+        }
         case ChannelCommand::MODE_L:
             channel->setMode(ChannelMode::USER_LIMIT, state, value, client);
             break;
@@ -329,67 +283,34 @@ void Server::_handleMode(const IRCMessage &token,
                                   channel->getChannelModesValues());
 }
 
-void Server::_handleUserhost(
-    const IRCMessage &token,
-    const std::shared_ptr<Client> &client) const noexcept {
-    std::shared_ptr<Client> targetClient = nullptr;
-    std::string uppercaseName = token.params[0];
-    std::transform(uppercaseName.begin(), uppercaseName.end(),
-                   uppercaseName.begin(), ::toupper);
-
-    for (auto const &it : _nick_to_client) {
-        std::string upperCaseIt = it.second->getNickname();
-        std::transform(upperCaseIt.begin(), upperCaseIt.end(),
-                       upperCaseIt.begin(), ::toupper);
-        if (upperCaseIt == uppercaseName) {
-            targetClient = it.second;
-            break;
-        }
-    }
-
-    if (targetClient == nullptr) {
-        std::cerr << "Server internal error: Could not found target "
-                     "user for USERHOST"
-                  << '\n';
+void Server::_handleUserhost(const IRCMessage &token,
+                             Client *client) const noexcept {
+    const auto target = _nick_to_client.find(token.params[0]);
+    if (target == _nick_to_client.end()) {
+        IRC_LOG(ERROR) << "Server internal error: Could not found target "
+                          "user for USERHOST";
         return;
     }
 
-    const std::string targetNick = targetClient->getNickname();
+    const std::string targetNick = target->second->getNickname();
     handleMsg(IRCCode::USERHOST, client, "",
               targetNick + "=-" + client->getFullID());
 }
 
-void Server::_handleUnkown(const IRCMessage &token,
-                           const std::shared_ptr<Client> &client) noexcept {
+void Server::_handleUnkown(const IRCMessage &token, Client *client) noexcept {
     return handleMsg(IRCCode::UNKNOWNCOMMAND, client, token.command,
                      "Unknown command");
 }
 
-void Server::_handleWhois(
-    const IRCMessage &token,
-    const std::shared_ptr<Client> &client) const noexcept {
+void Server::_handleWhois(const IRCMessage &token,
+                          Client *client) const noexcept {
     if (token.params.empty())
         return;
 
-    std::string upperCaseNick = token.params[0];
     std::stringstream msg;
-    bool control = true;
     const std::string &requester = client->getNickname();
-    std::shared_ptr<Client> targetClient = nullptr;
-    std::transform(upperCaseNick.begin(), upperCaseNick.end(),
-                   upperCaseNick.begin(), ::toupper);
-
-    for (auto const &it : _nick_to_client) {
-        std::string upperCaseIt = it.first;
-        std::transform(upperCaseIt.begin(), upperCaseIt.end(),
-                       upperCaseIt.begin(), ::toupper);
-        if (upperCaseIt == upperCaseNick) {
-            targetClient = it.second;
-            control = false;
-            break;
-        }
-    }
-    if (control) {
+    const auto target = _nick_to_client.find(token.params[0]);
+    if (target == _nick_to_client.end()) {
         msg.str("");
         msg.clear();
         msg << requester << " " << token.params[0];
@@ -397,6 +318,7 @@ void Server::_handleWhois(
         return;
     }
 
+    Client *targetClient = target->second;
     const std::string &targetNickname = targetClient->getNickname();
     const std::string &targetUsername = targetClient->getUsername();
     const std::string &targetIP = targetClient->getIP();
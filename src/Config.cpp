@@ -0,0 +1,187 @@
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <thread>
+
+#include "../include/Config.hpp"
+#include "../include/Utils.hpp"
+
+namespace {
+// Upper bounds for settings that have no natural one; past them a typo
+// would only buy a huge allocation, an overflowed product or a timer past
+// TimerWheel's range.
+constexpr std::size_t MAX_THREADS = 1024;
+constexpr std::size_t MAX_BYTES = std::size_t{1} << 30;
+constexpr std::size_t MAX_READ = std::size_t{1} << 24;
+constexpr std::size_t MAX_COUNT = std::size_t{1} << 20;
+constexpr std::size_t MAX_SECONDS = std::size_t{1} << 24;
+constexpr std::size_t MAX_USEC = 60 * 1000 * 1000;
+
+std::size_t envSizeT(const char *name, const std::size_t fallback,
+                     const std::size_t least, const std::size_t most) noexcept {
+    const char *value = std::getenv(name);
+    if (value == nullptr || *value == '\0') {
+        return fallback;
+    }
+
+    const std::size_t nbr = toSizeT(value);
+    if (errno != 0) {
+        errno = 0;
+        std::cerr << "Ignoring invalid " << name << "='" << value
+                  << "', using " << fallback << '\n';
+        return fallback;
+    }
+
+    if (nbr < least || nbr > most) {
+        std::cerr << "Ignoring " << name << "='" << value << "', not in "
+                  << least << ".." << most << ", using " << fallback << '\n';
+        return fallback;
+    }
+
+    return nbr;
+}
+
+IOBackend envBackend(const char *name, const IOBackend fallback) noexcept {
+    const char *value = std::getenv(name);
+    if (value == nullptr || *value == '\0') {
+        return fallback;
+    }
+
+    if (std::strcmp(value, "epoll") == 0) {
+        return IOBackend::EPOLL;
+    }
+
+    if (std::strcmp(value, "io_uring") == 0 ||
+        std::strcmp(value, "uring") == 0) {
+        return IOBackend::IO_URING;
+    }
+
+    std::cerr << "Ignoring unknown " << name << "='" << value << "'" << '\n';
+    return fallback;
+}
+
+SendQPolicy envPolicy(const char *name, const SendQPolicy fallback) noexcept {
+    const char *value = std::getenv(name);
+    if (value == nullptr || *value == '\0') {
+        return fallback;
+    }
+
+    if (std::strcmp(value, "drop") == 0) {
+        return SendQPolicy::DROP;
+    }
+
+    if (std::strcmp(value, "pause") == 0) {
+        return SendQPolicy::PAUSE;
+    }
+
+    if (std::strcmp(value, "disconnect") == 0) {
+        return SendQPolicy::DISCONNECT;
+    }
+
+    std::cerr << "Ignoring unknown " << name << "='" << value << "'" << '\n';
+    return fallback;
+}
+
+LogLevel envLogLevel(const char *name, const LogLevel fallback) noexcept {
+    const char *value = std::getenv(name);
+    if (value == nullptr || *value == '\0') {
+        return fallback;
+    }
+
+    if (std::strcmp(value, "trace") == 0 || std::strcmp(value, "debug") == 0) {
+        return LogLevel::TRACE;
+    }
+
+    if (std::strcmp(value, "info") == 0) {
+        return LogLevel::INFO;
+    }
+
+    if (std::strcmp(value, "warn") == 0) {
+        return LogLevel::WARN;
+    }
+
+    if (std::strcmp(value, "error") == 0) {
+        return LogLevel::ERROR;
+    }
+
+    if (std::strcmp(value, "off") == 0) {
+        return LogLevel::OFF;
+    }
+
+    std::cerr << "Ignoring unknown " << name << "='" << value << "'" << '\n';
+    return fallback;
+}
+
+// One connection class; the bucket's burst must fit Client's 16-bit count.
+void loadClass(const std::string &prefix, ConnectionClass &limits) noexcept {
+    limits.sendq =
+        envSizeT((prefix + "SENDQ").c_str(), limits.sendq, 0, MAX_BYTES);
+    limits.sendqPolicy =
+        envPolicy((prefix + "SENDQ_POLICY").c_str(), limits.sendqPolicy);
+    limits.floodBurst =
+        envSizeT((prefix + "FLOOD_BURST").c_str(), limits.floodBurst, 1,
+                 std::numeric_limits<std::uint16_t>::max());
+    limits.floodRate = envSizeT((prefix + "FLOOD_RATE").c_str(),
+                                limits.floodRate, 0, MAX_COUNT);
+}
+} // namespace
+
+Config loadConfig() noexcept {
+    Config config;
+
+    config.threads = envSizeT("IRC_THREADS", config.threads, 0, MAX_THREADS);
+    if (config.threads == 0) {
+        config.threads = std::thread::hardware_concurrency();
+        if (config.threads == 0) {
+            config.threads = 1;
+        }
+    }
+
+    config.backend = envBackend("IRC_BACKEND", config.backend);
+
+    config.acceptBatch =
+        envSizeT("IRC_ACCEPT_BATCH", config.acceptBatch, 1, MAX_COUNT);
+
+    const std::size_t edge = config.edgeTriggered ? 1 : 0;
+    config.edgeTriggered = envSizeT("IRC_EDGE_TRIGGERED", edge, 0, 1) != 0;
+    config.readSize = envSizeT("IRC_READ_SIZE", config.readSize, 1, MAX_READ);
+    config.readBudget =
+        envSizeT("IRC_READ_BUDGET", config.readBudget, 1, MAX_BYTES);
+    if (config.readBudget < config.readSize) {
+        config.readBudget = config.readSize;
+    }
+
+    config.channelLinger = envSizeT("IRC_CHANNEL_LINGER", config.channelLinger,
+                                    0, MAX_SECONDS);
+
+    config.dispatchTurn =
+        envSizeT("IRC_DISPATCH_TURN", config.dispatchTurn, 1, MAX_COUNT);
+    config.dispatchBudget =
+        envSizeT("IRC_DISPATCH_BUDGET", config.dispatchBudget, 0, MAX_USEC);
+
+    config.overloadLag =
+        envSizeT("IRC_OVERLOAD_LAG", config.overloadLag, 0, MAX_USEC);
+    config.overloadBacklog = envSizeT("IRC_OVERLOAD_BACKLOG",
+                                      config.overloadBacklog, 0, MAX_COUNT);
+
+    config.registrationTimeout =
+        envSizeT("IRC_REGISTRATION_TIMEOUT", config.registrationTimeout, 0,
+                 MAX_SECONDS);
+    config.idleTimeout =
+        envSizeT("IRC_IDLE_TIMEOUT", config.idleTimeout, 0, MAX_SECONDS);
+    config.inviteTimeout =
+        envSizeT("IRC_INVITE_TIMEOUT", config.inviteTimeout, 0, MAX_SECONDS);
+
+    config.logLevel = envLogLevel("IRC_LOG_LEVEL", config.logLevel);
+    config.logRing = envSizeT("IRC_LOG_RING", config.logRing, 1, MAX_COUNT);
+
+    loadClass("IRC_", config.registered);
+    loadClass("IRC_UNREGISTERED_", config.unregistered);
+
+    return config;
+}
@@ -0,0 +1,418 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "../include/Client.hpp"
+#include "../include/EpollBackend.hpp"
+#include "../include/Enums.hpp"
+#include "../include/Logger.hpp"
+#include "../include/OutputBuffer.hpp"
+#include "../include/Utils.hpp"
+
+namespace {
+// Registrations made here carry a tag in the upper half of data.u64; the
+// chatbot registers its sockets with plain data.fd, which leaves it zero.
+constexpr std::uint64_t CLIENT_TAG = 1ULL << 32;
+constexpr std::uint64_t LISTEN_TAG = 2ULL << 32;
+constexpr std::uint64_t WAKE_TAG = 3ULL << 32;
+constexpr std::uint64_t TAG_MASK = 0xFFFFFFFFULL << 32;
+
+// Segments gathered per sendmsg(): chunks of a client's own lines or
+// shared broadcast lines.
+constexpr std::size_t IOV_BATCH = 256;
+
+// The backend whose loop runs on this thread, so notifyEpollUpdate can tell
+// its own appends from those made by another reactor.
+thread_local const EpollBackend *t_owner{nullptr};
+} // namespace
+
+EpollBackend::EpollBackend(const Config &config)
+    : _epoll_fd(-1), _wake_fd(-1),
+      _events(static_cast<std::size_t>(Defaults::EVENT_SIZE)),
+      _accept_batch(config.acceptBatch),
+      _edge(config.edgeTriggered ? static_cast<std::uint32_t>(EPOLLET) : 0),
+      _read_budget(config.readBudget), _buffer(config.readSize) {
+}
+
+bool EpollBackend::init(const int listenFD) {
+    if (_accept_guard.reserve() != true) {
+        return false;
+    }
+
+    _epoll_fd = epoll_create1(0);
+    if (0 > _epoll_fd.get()) {
+        std::cerr << "Epoll create failed: " << strerror(errno) << '\n';
+        return false;
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = LISTEN_TAG | static_cast<std::uint32_t>(listenFD);
+    if (0 > epoll_ctl(_epoll_fd.get(), EPOLL_CTL_ADD, listenFD, &ev)) {
+        std::cerr << "Epoll add failed: " << strerror(errno) << '\n';
+        return false;
+    }
+
+    _wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (0 > _wake_fd.get()) {
+        std::cerr << "eventfd failed: " << strerror(errno) << '\n';
+        return false;
+    }
+
+    ev.events = EPOLLIN;
+    ev.data.u64 = WAKE_TAG;
+    if (0 > epoll_ctl(_epoll_fd.get(), EPOLL_CTL_ADD, _wake_fd.get(), &ev)) {
+        std::cerr << "Epoll add failed: " << strerror(errno) << '\n';
+        return false;
+    }
+
+    _listen_fd = listenFD;
+    return true;
+}
+
+int EpollBackend::wait(IOHandler &handler, const int timeout) {
+    t_owner = this;
+
+    bool pending = _backlog.empty() != true;
+    if (!pending) {
+        const std::lock_guard<std::mutex> lock(_dirty_mutex);
+        pending = _dirty.empty() != true;
+    }
+
+    const int nfds = epoll_wait(_epoll_fd.get(), _events.data(),
+                                static_cast<int>(_events.size()),
+                                pending ? 0 : timeout);
+    if (0 > nfds) {
+        if (errno == EINTR) {
+            return 0;
+        }
+
+        IRC_LOG(ERROR) << "Epoll wait failed: " << strerror(errno);
+        return -1;
+    }
+
+    for (int index = 0; index < nfds; ++index) {
+        const epoll_event &event = _events[static_cast<std::size_t>(index)];
+        const std::uint64_t tag = event.data.u64 & TAG_MASK;
+        const int fd = static_cast<int>(event.data.u64 & ~TAG_MASK);
+
+        if (tag == LISTEN_TAG) {
+            _accept(handler);
+        } else if (tag == WAKE_TAG) {
+            std::uint64_t value = 0;
+            if (0 > read(_wake_fd.get(), &value, sizeof(value)) &&
+                errno != EAGAIN) {
+                IRC_LOG(WARN) << "eventfd read failed: " << strerror(errno);
+            }
+        } else if (tag == CLIENT_TAG) {
+            // An edge is only reported once, so a wakeup that is both
+            // readable and writable has to be served for both.
+            if (event.events & EPOLLIN) {
+                _recv(handler, fd);
+            }
+
+            if (event.events & EPOLLOUT) {
+                handler.onWritable(_handle(fd));
+            } else if (!(event.events & EPOLLIN) &&
+                       (event.events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+                IRC_LOG(WARN)
+                    << "EpollBackend: EPOLLERR/HUP on client socket fd=" << fd
+                    << ". Removing client.";
+                handler.onClosed(_handle(fd));
+            }
+        } else {
+            handler.onAux(event.data.fd, event.events);
+        }
+    }
+
+    _recvBacklog(handler);
+    return nfds;
+}
+
+const char *EpollBackend::getName() const noexcept {
+    return "epoll";
+}
+
+IOStats EpollBackend::getStats() const noexcept {
+    IOStats stats{};
+    _accept_guard.fillStats(stats);
+    return stats;
+}
+
+bool EpollBackend::addClient(const ClientHandle client) {
+    const int fd = client.fd;
+    epoll_event ev{};
+    ev.events = EPOLLIN | _edge;
+    ev.data.u64 = CLIENT_TAG | static_cast<std::uint32_t>(fd);
+    if (0 > epoll_ctl(_epoll_fd.get(), EPOLL_CTL_ADD, fd, &ev)) {
+        IRC_LOG(WARN) << "Failed to add client to epoll: " << strerror(errno);
+        return false;
+    }
+
+    const std::size_t index = static_cast<std::size_t>(fd);
+    if (index >= _armed.size()) {
+        _generations.resize(index + 1, 0);
+        _armed.resize(index + 1, false);
+        _paused.resize(index + 1, false);
+    }
+    _generations[index] = client.generation;
+    _armed[index] = false;
+    _paused[index] = false;
+
+    return true;
+}
+
+void EpollBackend::removeClient(const int fd) {
+    epoll_ctl(_epoll_fd.get(), EPOLL_CTL_DEL, fd, nullptr);
+    if (static_cast<std::size_t>(fd) < _armed.size()) {
+        _armed[static_cast<std::size_t>(fd)] = false;
+        _paused[static_cast<std::size_t>(fd)] = false;
+    }
+    _backlog.erase(std::remove(_backlog.begin(), _backlog.end(), fd),
+                   _backlog.end());
+    std::replace(_ready.begin(), _ready.end(), fd, -1);
+}
+
+FlushResult EpollBackend::flush(Client &client) {
+    // Appenders only mark a client when its queue was empty, so whatever
+    // this leaves queued has to stay covered by EPOLLOUT.
+    const std::lock_guard<std::mutex> lock(client.getSendMutex());
+
+    OutputBuffer &output = client.getOutput();
+    while (output.empty() != true) {
+        iovec iov[IOV_BATCH];
+        msghdr msg{};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = output.fillIov(iov, IOV_BATCH);
+
+        if (Logger::enabled(LogLevel::TRACE)) {
+            logSend(client.getFD(), iov, msg.msg_iovlen);
+        }
+        const ssize_t bytes =
+            sendmsg(client.getFD(), &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+
+        if (0 > bytes) {
+            if (errno == EAGAIN) {
+                _setWritable(client.getFD(), true);
+                return FlushResult::PENDING;
+            }
+
+            if (errno == EINTR) {
+                continue;
+            }
+
+            IRC_LOG(WARN) << "Error while sending: " << strerror(errno);
+            return FlushResult::FAILED;
+        }
+
+        // A short write is retried at once: the next sendmsg() either makes
+        // progress or reports EAGAIN, which is what edge mode waits on.
+        output.consume(static_cast<std::size_t>(bytes));
+    }
+
+    _setWritable(client.getFD(), false);
+    return FlushResult::DONE;
+}
+
+// Re-adding EPOLLIN makes epoll look at the socket again, so input that
+// arrived while paused is reported even in edge mode.
+void EpollBackend::pauseRecv(const int fd, const bool paused) {
+    const std::size_t index = static_cast<std::size_t>(fd);
+    if (index >= _paused.size() || _paused[index] == paused) {
+        return;
+    }
+
+    _paused[index] = paused;
+    _setInterest(fd, _interest(index));
+    if (paused) {
+        _backlog.erase(std::remove(_backlog.begin(), _backlog.end(), fd),
+                       _backlog.end());
+    }
+}
+
+// The listener stays registered with no events, so level-triggered epoll
+// reports the queued connections again once EPOLLIN is back.
+void EpollBackend::deferAccept(const bool deferred) {
+    if (_accept_deferred == deferred) {
+        return;
+    }
+
+    _accept_deferred = deferred;
+    epoll_event ev{};
+    ev.events = deferred ? 0 : static_cast<std::uint32_t>(EPOLLIN);
+    ev.data.u64 = LISTEN_TAG | static_cast<std::uint32_t>(_listen_fd);
+    if (0 > epoll_ctl(_epoll_fd.get(), EPOLL_CTL_MOD, _listen_fd, &ev)) {
+        IRC_LOG(WARN) << "Epoll mod failed: " << strerror(errno);
+    }
+}
+
+void EpollBackend::flushPending(IOHandler &handler) {
+    {
+        const std::lock_guard<std::mutex> lock(_dirty_mutex);
+        _flushing.swap(_dirty);
+    }
+
+    // Anything marked while this runs waits for the next iteration, which
+    // then polls instead of sleeping.
+    for (const ClientHandle &client : _flushing) {
+        handler.onWritable(client);
+    }
+    _flushing.clear();
+}
+
+void EpollBackend::notifyEpollUpdate(const ClientHandle client) {
+    bool wake = false;
+
+    {
+        const std::lock_guard<std::mutex> lock(_dirty_mutex);
+        wake = _dirty.empty() && t_owner != this;
+        _dirty.push_back(client);
+    }
+
+    if (wake) {
+        const std::uint64_t one = 1;
+        if (0 > write(_wake_fd.get(), &one, sizeof(one))) {
+            IRC_LOG(WARN) << "eventfd write failed: " << strerror(errno);
+        }
+    }
+}
+
+int EpollBackend::getEpollFD() const noexcept {
+    return _epoll_fd.get();
+}
+
+void EpollBackend::_accept(IOHandler &handler) noexcept {
+    // The listener is level-triggered, so whatever is left past the batch
+    // is reported again on the next wait.
+    for (std::size_t count = 0; count < _accept_batch; ++count) {
+        sockaddr_in clientAddr{};
+        socklen_t clientLen = sizeof(clientAddr);
+        const int clientFD =
+            accept4(_listen_fd, reinterpret_cast<sockaddr *>(&clientAddr),
+                    &clientLen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+        if (0 > clientFD) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return;
+            }
+
+            if (errno == EMFILE || errno == ENFILE) {
+                if (_accept_guard.shed(_listen_fd) != true) {
+                    return;
+                }
+                continue;
+            }
+
+            _accept_guard.failed();
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+
+            IRC_LOG(WARN) << "Accept failed: " << strerror(errno);
+            return;
+        }
+
+        _accept_guard.accepted();
+        handler.onAccept(clientFD, &clientAddr);
+    }
+}
+
+void EpollBackend::_recv(IOHandler &handler, const int fd) noexcept {
+    std::size_t total = 0;
+
+    while (total < _read_budget) {
+        const ssize_t bytes_read =
+            recv(fd, _buffer.data(), _buffer.size(), MSG_DONTWAIT);
+        if (0 > bytes_read) {
+            if (errno == EAGAIN) {
+                return;
+            }
+
+            if (errno == EINTR) {
+                continue;
+            }
+
+            IRC_LOG(WARN) << "Error while recv: " << strerror(errno);
+            return handler.onClosed(_handle(fd));
+        }
+
+        if (bytes_read == 0) {
+            return handler.onClosed(_handle(fd));
+        }
+
+        total += static_cast<std::size_t>(bytes_read);
+        handler.onRecv(_handle(fd), _buffer.data(),
+                       static_cast<std::size_t>(bytes_read));
+    }
+
+    // Level-triggered epoll reports the rest on the next wait by itself.
+    if (_edge != 0 &&
+        std::find(_backlog.begin(), _backlog.end(), fd) == _backlog.end()) {
+        _backlog.push_back(fd);
+    }
+}
+
+void EpollBackend::_recvBacklog(IOHandler &handler) noexcept {
+    if (_backlog.empty()) {
+        return;
+    }
+
+    // _recv may put an fd straight back; removeClient blanks the ones it
+    // drops while this pass runs.
+    _ready.swap(_backlog);
+    for (std::size_t index = 0; index < _ready.size(); ++index) {
+        if (_ready[index] >= 0) {
+            _recv(handler, _ready[index]);
+        }
+    }
+    _ready.clear();
+}
+
+void EpollBackend::_setWritable(const int fd, const bool armed) noexcept {
+    const std::size_t index = static_cast<std::size_t>(fd);
+    if (index >= _armed.size() || _armed[index] == armed) {
+        return;
+    }
+
+    _armed[index] = armed;
+    _setInterest(fd, _interest(index));
+}
+
+std::uint32_t EpollBackend::_interest(const std::size_t index) const noexcept {
+    std::uint32_t events = _edge;
+    if (_paused[index] != true) {
+        events |= EPOLLIN;
+    }
+    if (_armed[index]) {
+        events |= EPOLLOUT;
+    }
+
+    return events;
+}
+
+ClientHandle EpollBackend::_handle(const int fd) const noexcept {
+    return ClientHandle{fd, _generations[static_cast<std::size_t>(fd)]};
+}
+
+void EpollBackend::_setInterest(const int fd,
+                                const std::uint32_t events) noexcept {
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.u64 = CLIENT_TAG | static_cast<std::uint32_t>(fd);
+    if (0 > epoll_ctl(_epoll_fd.get(), EPOLL_CTL_MOD, fd, &ev)) {
+        IRC_LOG(WARN) << "Failed to update epoll: " << strerror(errno);
+    }
+}
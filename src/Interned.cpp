@@ -0,0 +1,105 @@
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "../include/Interned.hpp"
+
+namespace {
+struct Pool {
+    std::mutex mutex;
+    std::unordered_map<std::string, std::size_t> entries; // value -> refs
+};
+
+// Never destroyed: clients released during static destruction still need
+// it.
+Pool &pool() {
+    static Pool *instance = new Pool();
+    return *instance;
+}
+
+const std::string &emptyString() noexcept {
+    static const std::string empty;
+    return empty;
+}
+} // namespace
+
+Interned::Interned(const std::string &value) {
+    if (value.empty()) {
+        return;
+    }
+
+    Pool &shared = pool();
+    const std::lock_guard<std::mutex> lock(shared.mutex);
+    // Map nodes never move, so the entry stays put while referenced.
+    _entry = &*shared.entries.emplace(value, 0).first;
+    ++_entry->second;
+}
+
+Interned::Interned(const Interned &rhs) noexcept : _entry(rhs._entry) {
+    _acquire();
+}
+
+Interned &Interned::operator=(const Interned &rhs) noexcept {
+    if (_entry != rhs._entry) {
+        rhs._acquire();
+        _release();
+        _entry = rhs._entry;
+    }
+
+    return *this;
+}
+
+Interned::Interned(Interned &&rhs) noexcept : _entry(rhs._entry) {
+    rhs._entry = nullptr;
+}
+
+Interned &Interned::operator=(Interned &&rhs) noexcept {
+    if (this != &rhs) {
+        _release();
+        _entry = rhs._entry;
+        rhs._entry = nullptr;
+    }
+
+    return *this;
+}
+
+Interned::~Interned() {
+    _release();
+}
+
+const std::string &Interned::str() const noexcept {
+    if (_entry == nullptr) {
+        return emptyString();
+    }
+
+    return _entry->first;
+}
+
+bool Interned::empty() const noexcept {
+    return _entry == nullptr;
+}
+
+void Interned::_acquire() const noexcept {
+    if (_entry == nullptr) {
+        return;
+    }
+
+    Pool &shared = pool();
+    const std::lock_guard<std::mutex> lock(shared.mutex);
+    ++_entry->second;
+}
+
+void Interned::_release() noexcept {
+    if (_entry == nullptr) {
+        return;
+    }
+
+    Pool &shared = pool();
+    const std::lock_guard<std::mutex> lock(shared.mutex);
+    if (--_entry->second == 0) {
+        shared.entries.erase(shared.entries.find(_entry->first));
+    }
+    _entry = nullptr;
+}
@@ -0,0 +1,65 @@
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "../include/LineBuffer.hpp"
+
+LineBuffer::LineBuffer(const std::size_t limit) noexcept
+    : _limit(static_cast<std::uint32_t>(limit)) {
+}
+
+LineBuffer::LineBuffer(LineBuffer &&rhs) noexcept
+    : _tail(std::move(rhs._tail)), _limit(rhs._limit),
+      _skipping(rhs._skipping) {
+    rhs._skipping = false;
+}
+
+LineBuffer &LineBuffer::operator=(LineBuffer &&rhs) noexcept {
+    if (this != &rhs) {
+        _tail = std::move(rhs._tail);
+        _limit = rhs._limit;
+        _skipping = rhs._skipping;
+        rhs._skipping = false;
+    }
+
+    return *this;
+}
+
+bool LineBuffer::empty() const noexcept {
+    return _tail.empty();
+}
+
+std::size_t LineBuffer::capacity() const noexcept {
+    return _tail.capacity();
+}
+
+// Holds on to an unterminated piece of a line. Returns false when that
+// first pushes the line past the limit; the line is then skipped up to its CRLF,
+// keeping only a trailing '\r' in case the LF is in the next read.
+bool LineBuffer::_keep(const char *data, const std::size_t length) noexcept {
+    const bool cr = data[length - 1] == '\r';
+    bool fits = true;
+
+    if (_skipping != true) {
+        const std::size_t size = _tail.size() + length - (cr ? 1 : 0);
+        if (size <= _limit) {
+            _tail.append(data, length);
+            return true;
+        }
+        _skipping = true;
+        fits = false;
+    }
+
+    _tail.clear();
+    if (cr) {
+        _tail.push_back('\r');
+    }
+
+    return fits;
+}
+
+// Gives back the tail's heap block, so an idle client holds none.
+void LineBuffer::_release() noexcept {
+    std::string().swap(_tail);
+}
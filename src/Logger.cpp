@@ -0,0 +1,229 @@
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+#include "../include/Logger.hpp"
+
+namespace {
+// The ring holds 2^n records of 512 bytes, 8 KiB to 32 MiB.
+constexpr std::size_t MIN_SLOTS = 16;
+constexpr std::size_t MAX_SLOTS = 1 << 16;
+
+// Written once this much is gathered, or the ring is empty.
+constexpr std::size_t BATCH = 64 * 1024;
+
+// How long the writer sleeps when the ring is empty.
+constexpr std::chrono::milliseconds IDLE{10};
+
+constexpr char CUT[] = "...";
+} // namespace
+
+constexpr std::size_t Logger::TEXT;
+
+std::atomic<LogLevel> Logger::_level{LogLevel::INFO};
+std::atomic<Logger *> Logger::_active{nullptr};
+
+Logger::Logger(const Config &config) : _mask(0) {
+    std::size_t slots = MIN_SLOTS;
+    while (slots < config.logRing && slots < MAX_SLOTS) {
+        slots <<= 1;
+    }
+
+    _ring.reset(new Slot[slots]);
+    _mask = slots - 1;
+    for (std::size_t index = 0; index < slots; ++index) {
+        _ring[index].sequence.store(index, std::memory_order_relaxed);
+    }
+
+    // Room for a full batch plus one record and the drop notice, so
+    // appending never reallocates on the writer thread.
+    _batch.reserve(BATCH + TEXT + 64);
+    _writer = std::thread(&Logger::_write, this);
+
+    _level.store(config.logLevel, std::memory_order_relaxed);
+    _active.store(this, std::memory_order_release);
+}
+
+Logger::~Logger() {
+    _active.store(nullptr, std::memory_order_release);
+    _stop.store(true, std::memory_order_release);
+    if (_writer.joinable()) {
+        _writer.join();
+    }
+}
+
+void Logger::submit(const LogLevel level, const char *text,
+                    const std::size_t length) noexcept {
+    if (enabled(level) != true) {
+        return;
+    }
+
+    Logger *logger = _active.load(std::memory_order_acquire);
+    if (logger == nullptr) {
+        std::cerr.write(text, static_cast<std::streamsize>(length)) << '\n';
+        return;
+    }
+
+    logger->_push(text, length);
+}
+
+// A bounded queue after Dmitry Vyukov's: producers race for a position with
+// one CAS, then own its slot until they publish it through `sequence`.
+void Logger::_push(const char *text, std::size_t length) noexcept {
+    std::uint64_t pos = _head.load(std::memory_order_relaxed);
+    Slot *slot = nullptr;
+    for (;;) {
+        slot = &_ring[pos & _mask];
+        const std::uint64_t sequence =
+            slot->sequence.load(std::memory_order_acquire);
+        const std::int64_t ahead = static_cast<std::int64_t>(sequence - pos);
+        if (ahead == 0) {
+            if (_head.compare_exchange_weak(pos, pos + 1,
+                                            std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (ahead < 0) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = _head.load(std::memory_order_relaxed);
+        }
+    }
+
+    if (length > TEXT) {
+        length = TEXT;
+    }
+    std::memcpy(slot->text, text, length);
+    slot->length = static_cast<std::uint16_t>(length);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+}
+
+// Sleeps only while there is nothing to write; once stopped, writes out
+// what was pushed before and returns.
+void Logger::_write() noexcept {
+    for (;;) {
+        const bool stopping = _stop.load(std::memory_order_acquire);
+        _drain();
+        if (_batch.empty() != true) {
+            _flush();
+            continue;
+        }
+
+        if (stopping) {
+            return;
+        }
+        std::this_thread::sleep_for(IDLE);
+    }
+}
+
+void Logger::_drain() noexcept {
+    while (_batch.size() < BATCH) {
+        Slot &slot = _ring[_tail & _mask];
+        if (slot.sequence.load(std::memory_order_acquire) != _tail + 1) {
+            break;
+        }
+
+        _batch.append(slot.text, slot.length);
+        _batch.push_back('\n');
+        slot.sequence.store(_tail + _mask + 1, std::memory_order_release);
+        ++_tail;
+    }
+
+    const std::uint64_t dropped = _dropped.load(std::memory_order_relaxed);
+    if (dropped != _reported) {
+        char notice[64];
+        const int length = std::snprintf(
+            notice, sizeof(notice), "Logger: ring full, dropped %llu records\n",
+            static_cast<unsigned long long>(dropped - _reported));
+        if (length > 0) {
+            _batch.append(notice, static_cast<std::size_t>(length));
+        }
+        _reported = dropped;
+    }
+}
+
+void Logger::_flush() noexcept {
+    std::size_t done = 0;
+    while (done < _batch.size()) {
+        const ssize_t wrote =
+            ::write(STDERR_FILENO, _batch.data() + done, _batch.size() - done);
+        if (wrote < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break; // nowhere left to report it
+        }
+        done += static_cast<std::size_t>(wrote);
+    }
+
+    _batch.clear();
+}
+
+LogLine::LogLine(const LogLevel level) noexcept : _level(level) {
+}
+
+LogLine::~LogLine() {
+    Logger::submit(_level, _text, _length);
+}
+
+LogLine &LogLine::operator<<(const char *text) noexcept {
+    if (text != nullptr) {
+        _append(text, std::strlen(text));
+    }
+    return *this;
+}
+
+LogLine &LogLine::operator<<(const std::string &text) noexcept {
+    _append(text.data(), text.size());
+    return *this;
+}
+
+LogLine &LogLine::operator<<(const StringView &text) noexcept {
+    _append(text.data(), text.size());
+    return *this;
+}
+
+LogLine &LogLine::operator<<(const char c) noexcept {
+    _append(&c, 1);
+    return *this;
+}
+
+// Keeps room for CUT, which ends a record that did not fit.
+void LogLine::_append(const char *text, const std::size_t length) noexcept {
+    const std::size_t room = sizeof(_text) - (sizeof(CUT) - 1);
+    if (_cut) {
+        return;
+    }
+
+    if (length > room - _length) {
+        std::memcpy(_text + _length, text, room - _length);
+        std::memcpy(_text + room, CUT, sizeof(CUT) - 1);
+        _length = sizeof(_text);
+        _cut = true;
+        return;
+    }
+
+    std::memcpy(_text + _length, text, length);
+    _length += length;
+}
+
+void LogLine::_number(const long long value) noexcept {
+    char digits[24];
+    const int length = std::snprintf(digits, sizeof(digits), "%lld", value);
+    _append(digits, static_cast<std::size_t>(length));
+}
+
+void LogLine::_number(const unsigned long long value) noexcept {
+    char digits[24];
+    const int length = std::snprintf(digits, sizeof(digits), "%llu", value);
+    _append(digits, static_cast<std::size_t>(length));
+}
@@ -0,0 +1,92 @@
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "../include/LoopMonitor.hpp"
+
+void LoopMonitor::init(const Config &config) noexcept {
+    _lag_limit = config.overloadLag;
+    _backlog_limit = config.overloadBacklog;
+}
+
+bool LoopMonitor::sample(const std::chrono::steady_clock::time_point now,
+                         const std::chrono::microseconds busy,
+                         const std::size_t backlog) noexcept {
+    const std::uint64_t work = static_cast<std::uint64_t>(busy.count());
+    _lag = (_lag * 3 + work) / 4;
+    _shown_lag.store(_lag, std::memory_order_relaxed);
+    _shown_backlog.store(backlog, std::memory_order_relaxed);
+    if (_lag_limit == 0) {
+        return false;
+    }
+
+    OverloadTier target = OverloadTier::NORMAL;
+    if (_lag >= _enterAt(OverloadTier::SHED_FEATURES)) {
+        target = OverloadTier::SHED_FEATURES;
+    } else if (_lag >= _enterAt(OverloadTier::PAUSE_HEAVY)) {
+        target = OverloadTier::PAUSE_HEAVY;
+    } else if (_lag >= _enterAt(OverloadTier::DEFER_ACCEPT) ||
+               (_backlog_limit != 0 && backlog >= _backlog_limit)) {
+        target = OverloadTier::DEFER_ACCEPT;
+    }
+
+    const OverloadTier tier = _tier.load(std::memory_order_relaxed);
+    OverloadTier next = tier;
+    if (target > tier) {
+        next = target;
+    } else if (target < tier && _lag < _enterAt(tier) / 2 &&
+               now - _changed >= std::chrono::milliseconds(
+                                      getDefaultValue(Defaults::INTERVAL)) &&
+               (tier != OverloadTier::DEFER_ACCEPT || _backlog_limit == 0 ||
+                backlog < _backlog_limit / 2)) {
+        next = static_cast<OverloadTier>(static_cast<std::uint8_t>(tier) - 1);
+    }
+
+    if (next == tier) {
+        return false;
+    }
+
+    _changed = now;
+    _tier.store(next, std::memory_order_relaxed);
+    _transitions.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void LoopMonitor::pausedClient() noexcept {
+    _paused.fetch_add(1, std::memory_order_relaxed);
+}
+
+OverloadTier LoopMonitor::getTier() const noexcept {
+    return _tier.load(std::memory_order_relaxed);
+}
+
+LoadStats LoopMonitor::getStats() const noexcept {
+    return LoadStats{_tier.load(std::memory_order_relaxed),
+                     _shown_lag.load(std::memory_order_relaxed),
+                     _shown_backlog.load(std::memory_order_relaxed),
+                     _transitions.load(std::memory_order_relaxed),
+                     _paused.load(std::memory_order_relaxed)};
+}
+
+std::uint64_t LoopMonitor::_enterAt(const OverloadTier tier) const noexcept {
+    if (tier == OverloadTier::NORMAL) {
+        return 0;
+    }
+
+    return _lag_limit << (static_cast<std::uint8_t>(tier) - 1);
+}
+
+const char *toString(const OverloadTier tier) noexcept {
+    if (tier == OverloadTier::DEFER_ACCEPT) {
+        return "defer-accept";
+    }
+    if (tier == OverloadTier::PAUSE_HEAVY) {
+        return "pause-heavy";
+    }
+    if (tier == OverloadTier::SHED_FEATURES) {
+        return "shed-features";
+    }
+
+    return "normal";
+}
@@ -0,0 +1,198 @@
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "../include/Client.hpp"
+#include "../include/MemberTable.hpp"
+
+namespace {
+std::uint8_t bit(const MemberFlag flag) noexcept {
+    return static_cast<std::uint8_t>(flag);
+}
+} // namespace
+
+bool Member::has(const MemberFlag flag) const noexcept {
+    return (flags & bit(flag)) != 0;
+}
+
+MemberTable::MemberTable(MemberTable &&rhs) noexcept
+    : _entries(std::move(rhs._entries)), _index(std::move(rhs._index)),
+      _joined(rhs._joined), _operators(rhs._operators),
+      _serial(rhs._serial) {
+    rhs._joined = 0;
+    rhs._operators = 0;
+}
+
+MemberTable &MemberTable::operator=(MemberTable &&rhs) noexcept {
+    if (this != &rhs) {
+        _entries = std::move(rhs._entries);
+        _index = std::move(rhs._index);
+        _joined = rhs._joined;
+        _operators = rhs._operators;
+        _serial = rhs._serial;
+        rhs._joined = 0;
+        rhs._operators = 0;
+    }
+
+    return *this;
+}
+
+bool MemberTable::has(Client *client, const MemberFlag flag) const noexcept {
+    const auto it = _index.find(client);
+    if (it == _index.end()) {
+        return false;
+    }
+
+    return _entries[it->second].has(flag);
+}
+
+void MemberTable::set(Client *client, const MemberFlag flag) {
+    std::size_t slot = 0;
+    const auto it = _index.find(client);
+    if (it == _index.end()) {
+        slot = _entries.size();
+        _entries.push_back(Member{client, 0, 0, 0});
+        _index.emplace(client, slot);
+    } else {
+        slot = it->second;
+    }
+
+    if (_entries[slot].has(flag)) {
+        return;
+    }
+
+    if (flag == MemberFlag::JOINED) {
+        _swap(slot, _joined);
+        slot = _joined;
+        ++_joined;
+    } else if (flag == MemberFlag::OPERATOR) {
+        ++_operators;
+    }
+
+    _entries[slot].flags = static_cast<std::uint8_t>(_entries[slot].flags |
+                                                     bit(flag));
+}
+
+void MemberTable::clear(Client *client, const MemberFlag flag) noexcept {
+    const auto it = _index.find(client);
+    if (it == _index.end()) {
+        return;
+    }
+
+    std::size_t slot = it->second;
+    if (_entries[slot].has(flag) != true) {
+        return;
+    }
+
+    _entries[slot].flags =
+        static_cast<std::uint8_t>(_entries[slot].flags & ~bit(flag));
+
+    if (flag == MemberFlag::JOINED) {
+        --_joined;
+        _swap(slot, _joined);
+        slot = _joined;
+    } else if (flag == MemberFlag::OPERATOR) {
+        --_operators;
+    }
+
+    if (_entries[slot].flags == 0) {
+        _swap(slot, _entries.size() - 1);
+        _index.erase(client);
+        _entries.pop_back();
+    }
+}
+
+std::uint16_t MemberTable::invite(Client *client,
+                                  const std::uint32_t generation) {
+    set(client, MemberFlag::INVITED);
+
+    if (++_serial == 0) {
+        ++_serial;
+    }
+
+    Member &entry = _entries[_index.find(client)->second];
+    entry.edge = generation;
+    entry.serial = _serial;
+    return _serial;
+}
+
+bool MemberTable::invited(const Client *client,
+                          const std::uint32_t generation) const noexcept {
+    const auto it = _index.find(client);
+    if (it == _index.end()) {
+        return false;
+    }
+
+    const Member &entry = _entries[it->second];
+    return entry.has(MemberFlag::INVITED) &&
+           entry.has(MemberFlag::JOINED) != true && entry.edge == generation;
+}
+
+bool MemberTable::expire(Client *client, const std::uint32_t generation,
+                         const std::uint16_t serial) noexcept {
+    const auto it = _index.find(client);
+    if (it == _index.end()) {
+        return false;
+    }
+
+    const Member &entry = _entries[it->second];
+    if (entry.has(MemberFlag::INVITED) != true ||
+        entry.has(MemberFlag::JOINED) || entry.edge != generation ||
+        entry.serial != serial) {
+        return false;
+    }
+
+    clear(client, MemberFlag::INVITED);
+    return true;
+}
+
+void MemberTable::dropInvites() noexcept {
+    for (std::size_t slot = _joined; slot < _entries.size(); ++slot) {
+        _index.erase(_entries[slot].client);
+    }
+    _entries.erase(_entries.begin() + static_cast<std::ptrdiff_t>(_joined),
+                   _entries.end());
+}
+
+std::uint32_t MemberTable::edge(Client *client) const noexcept {
+    const auto it = _index.find(client);
+    if (it == _index.end()) {
+        return 0;
+    }
+
+    return _entries[it->second].edge;
+}
+
+void MemberTable::setEdge(Client *client, const std::uint32_t edge) noexcept {
+    const auto it = _index.find(client);
+    if (it != _index.end()) {
+        _entries[it->second].edge = edge;
+    }
+}
+
+std::size_t MemberTable::joined() const noexcept {
+    return _joined;
+}
+
+std::size_t MemberTable::operators() const noexcept {
+    return _operators;
+}
+
+const Member *MemberTable::begin() const noexcept {
+    return _entries.data();
+}
+
+const Member *MemberTable::end() const noexcept {
+    return _entries.data() + _joined;
+}
+
+void MemberTable::_swap(const std::size_t lhs, const std::size_t rhs) noexcept {
+    if (lhs == rhs) {
+        return;
+    }
+
+    std::swap(_entries[lhs], _entries[rhs]);
+    _index[_entries[lhs].client] = lhs;
+    _index[_entries[rhs].client] = rhs;
+}
@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/uio.h>
+
+#include "../include/OutputBuffer.hpp"
+
+namespace {
+constexpr std::size_t CHUNK_SIZE = 4096;
+constexpr std::size_t IDLE_SEGMENTS = 8; // kept across drains
+} // namespace
+
+OutputBuffer::OutputBuffer(OutputBuffer &&rhs) noexcept
+    : _segments(std::move(rhs._segments)), _head(rhs._head),
+      _size(rhs._size) {
+    rhs._head = 0;
+    rhs._size = 0;
+}
+
+OutputBuffer &OutputBuffer::operator=(OutputBuffer &&rhs) noexcept {
+    if (this != &rhs) {
+        _segments = std::move(rhs._segments);
+        _head = rhs._head;
+        _size = rhs._size;
+        rhs._head = 0;
+        rhs._size = 0;
+    }
+
+    return *this;
+}
+
+Payload makePayload(std::string line) {
+    return std::make_shared<const std::string>(std::move(line));
+}
+
+void OutputBuffer::append(const char *data, std::size_t length) {
+    while (length > 0) {
+        if (_segments.size() == _head || _segments.back().shared ||
+            _segments.back().end == CHUNK_SIZE) {
+            _segments.push_back(Segment{
+                std::unique_ptr<char[]>(new char[CHUNK_SIZE]), nullptr, 0, 0});
+        }
+
+        Segment &chunk = _segments.back();
+        const std::size_t room = std::min(length, CHUNK_SIZE - chunk.end);
+        std::memcpy(chunk.data.get() + chunk.end, data, room);
+        chunk.end += room;
+        _size += room;
+
+        data += room;
+        length -= room;
+    }
+}
+
+void OutputBuffer::append(const std::string &data) {
+    append(data.data(), data.length());
+}
+
+void OutputBuffer::append(const Payload &payload) {
+    if (payload && payload->empty() != true) {
+        _segments.push_back(Segment{nullptr, payload, 0, payload->length()});
+        _size += payload->length();
+    }
+}
+
+bool OutputBuffer::empty() const noexcept {
+    return _size == 0;
+}
+
+std::size_t OutputBuffer::size() const noexcept {
+    return _size;
+}
+
+std::size_t OutputBuffer::fillIov(iovec *iov,
+                                  const std::size_t count) const noexcept {
+    std::size_t filled = 0;
+
+    for (std::size_t index = _head; index < _segments.size(); ++index) {
+        if (filled == count) {
+            break;
+        }
+
+        const Segment &segment = _segments[index];
+        const char *base = segment.shared ? segment.shared->data()
+                                          : segment.data.get();
+        iov[filled].iov_base = const_cast<char *>(base + segment.begin);
+        iov[filled].iov_len = segment.end - segment.begin;
+        ++filled;
+    }
+
+    return filled;
+}
+
+void OutputBuffer::consume(std::size_t bytes) noexcept {
+    bytes = std::min(bytes, _size);
+    _size -= bytes;
+
+    while (bytes > 0) {
+        Segment &segment = _segments[_head];
+        const std::size_t used = std::min(bytes, segment.end - segment.begin);
+        segment.begin += used;
+        bytes -= used;
+
+        if (segment.begin == segment.end) {
+            segment.data.reset();
+            segment.shared.reset();
+            ++_head;
+        }
+    }
+
+    if (_size == 0) {
+        return clear();
+    }
+
+    if (_head * 2 >= _segments.size()) {
+        _segments.erase(_segments.begin(),
+                        _segments.begin() +
+                            static_cast<std::ptrdiff_t>(_head));
+        _head = 0;
+    }
+}
+
+// A drained queue keeps a few segment slots for the next burst; a client
+// that once had a deep backlog gives the rest back.
+void OutputBuffer::clear() noexcept {
+    if (_segments.capacity() > IDLE_SEGMENTS) {
+        std::vector<Segment>().swap(_segments);
+    } else {
+        _segments.clear();
+    }
+    _head = 0;
+    _size = 0;
+}
@@ -0,0 +1,125 @@
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "../include/Client.hpp"
+#include "../include/Enums.hpp"
+#include "../include/EpollBackend.hpp"
+#include "../include/Reactor.hpp"
+#include "../include/UringBackend.hpp"
+
+Reactor::Reactor(const std::size_t id)
+    : _id(id), _listen_fd(-1),
+      _timers(std::chrono::milliseconds(getDefaultValue(Defaults::INTERVAL))) {
+}
+
+bool Reactor::init(const std::uint16_t port, const Config &config) noexcept {
+    _monitor.init(config);
+
+    _listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (0 > _listen_fd.get()) {
+        std::cerr << "Failed to create a socket: " << strerror(errno) << '\n';
+        return false;
+    }
+
+    constexpr int opt = 1;
+    if (0 > setsockopt(_listen_fd.get(), SOL_SOCKET, SO_REUSEADDR, &opt,
+                       sizeof(opt))) {
+        std::cerr << "setsockopt failed: " << strerror(errno) << '\n';
+        return false;
+    }
+
+    if (0 > setsockopt(_listen_fd.get(), SOL_SOCKET, SO_REUSEPORT, &opt,
+                       sizeof(opt))) {
+        std::cerr << "setsockopt SO_REUSEPORT failed: " << strerror(errno)
+                  << '\n';
+        return false;
+    }
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = INADDR_ANY;
+    address.sin_port = htons(port);
+    if (0 > bind(_listen_fd.get(), (sockaddr *)&address, sizeof(address))) {
+        std::cerr << "Bind failed: " << strerror(errno) << '\n';
+        return false;
+    }
+
+    if (0 > listen(_listen_fd.get(), SOMAXCONN)) {
+        std::cerr << "Listen failed: " << strerror(errno) << '\n';
+        return false;
+    }
+
+    if (config.backend == IOBackend::IO_URING) {
+        _backend.reset(new UringBackend(config));
+        if (_backend->init(_listen_fd.get())) {
+            return true;
+        }
+
+        std::cerr << "io_uring unavailable, falling back to epoll" << '\n';
+    }
+
+    _backend.reset(new EpollBackend(config));
+    return _backend->init(_listen_fd.get());
+}
+
+std::size_t Reactor::getID() const noexcept {
+    return _id;
+}
+
+int Reactor::getListenFD() const noexcept {
+    return _listen_fd.get();
+}
+
+int Reactor::getEpollFD() const noexcept {
+    return _backend->getEpollFD();
+}
+
+EpollInterface &Reactor::backend() noexcept {
+    return *_backend;
+}
+
+LoopMonitor &Reactor::monitor() noexcept {
+    return _monitor;
+}
+
+const LoopMonitor &Reactor::monitor() const noexcept {
+    return _monitor;
+}
+
+std::unordered_map<int, ApiRequest> &Reactor::apiRequests() noexcept {
+    return _api_requests;
+}
+
+std::vector<Inbound> &Reactor::inbox() noexcept {
+    return _inbox;
+}
+
+std::vector<Inbound> &Reactor::held() noexcept {
+    return _held;
+}
+
+std::vector<ClientHandle> &Reactor::paused() noexcept {
+    return _paused;
+}
+
+std::vector<ClientHandle> &Reactor::closed() noexcept {
+    return _closed;
+}
+
+std::vector<int> &Reactor::retired() noexcept {
+    return _retired;
+}
+
+TimerWheel<ClientHandle> &Reactor::timers() noexcept {
+    return _timers;
+}
@@ -0,0 +1,174 @@
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../include/Enums.hpp"
+#include "../include/ReplyCatalog.hpp"
+#include "../include/Utils.hpp"
+
+namespace {
+constexpr std::size_t MAX_CODE = 1000;
+
+// After the ":<server> <numeric>" head, which numeric entries get for
+// free. $n nick, $* nick or "*", $f nick!user@host, $v value, $m msg; $S,
+// $R, $L and $W are the server name, version, NICKLEN and network name,
+// rendered at startup.
+struct ReplyEntry {
+    IRCCode code;
+    bool numeric;
+    const char *format;
+};
+
+constexpr ReplyEntry ENTRIES[] = {
+    {IRCCode::WELCOME, true, " $n :Welcome to the IRCCodam Network $f"},
+    {IRCCode::YOURHOST, true, " $n :Your host is $S, running version $R"},
+    {IRCCode::CREATED, true, " $n :This server was created $m"},
+    {IRCCode::MYINFO, true, " $n $S $R $m"},
+    {IRCCode::ISUPPORT, true,
+     " $n CASEMAPPING=rfc1459 CHANMODES=i,t,k,o,l CHANTYPES=# PREFIX=(o)@ "
+     "STATUSMSG=@ NICKLEN=$L NETWORK=$W :are supported by this server"},
+    {IRCCode::USERHOST, true, " $n :$m"},
+    {IRCCode::RPL_WHOISUSER, true, "$m"},
+    {IRCCode::RPL_WHOISSERVER, true, " :$m"},
+    {IRCCode::RPL_ENDOFWHOIS, true, " $m :End of WHOIS list"},
+    {IRCCode::CHANNELMODEIS, true, " $n $v $m"},
+    {IRCCode::TOPIC, true, " $n $v $m"},
+    {IRCCode::INVITING, true, " $n $v $m"},
+    {IRCCode::NAMREPLY, true, " $n = $v :$m"},
+    {IRCCode::ENDOFNAMES, true, " $n  $v :End of /NAMES list"},
+    {IRCCode::MOTD, true, " :$m"},
+    {IRCCode::MOTDSTART, true, " $n :- Message of the Day -"},
+    {IRCCode::ENDOFMOTD, true, " $n :End of /MOTD command"},
+    {IRCCode::NOSUCHNICK, true, " $n $v :No such nick/channel"},
+    {IRCCode::NOSUCHCHANNEL, true, " $n $v :No such channel"},
+    {IRCCode::CANNOTSENDTOCHAN, true, "$v :Cannot send to channel"},
+    {IRCCode::TOMANYCHANNELS, true, "$v :You have joined too many channels"},
+    {IRCCode::NORECIPIENT, true, "$v :No recipient given $m"},
+    {IRCCode::NOTEXTTOSEND, true, " $v :No text to send"},
+    {IRCCode::INPUTTOOLONG, true, " $n :Input was too long"},
+    {IRCCode::UNKNOWNCOMMAND, true, " $n $v :$m"},
+    {IRCCode::NONICK, true, " * $v :No nickname given"},
+    {IRCCode::ERRONUENICK, true, " * $v :Erronues nickname"},
+    {IRCCode::NICKINUSE, true, " $* $v :Nickname is already in use"},
+    {IRCCode::USERNOTINCHANNEL, true,
+     " $n $v $m :They aren't on that channel"},
+    {IRCCode::NOTOCHANNEL, true, "$v :You're not on that channel"},
+    {IRCCode::USERONCHANNEL, true, " $v $m :is already in channel"},
+    {IRCCode::NOTREGISTERED, true, " :You have not registered"},
+    {IRCCode::NEEDMOREPARAMS, true, " $n $v :Not enough parameters"},
+    {IRCCode::ALREADYREGISTERED, true, " :You may not reregister"},
+    {IRCCode::PASSWDMISMATCH, true, " * :Password incorrect"},
+    {IRCCode::KEYSET, true, "$v :Channel key already set"},
+    {IRCCode::INVALIDUSERNAME, true, " * $v :Erronues username"},
+    {IRCCode::CHANNELISFULL, true, " $v :Cannot join channel (+l)"},
+    {IRCCode::UNKNOWMODE, true, " $v :is unknown mode char to me"},
+    {IRCCode::INVITEONLYCHAN, true, " $v :Cannot join channel (+i)"},
+    {IRCCode::BADCHANNELKEY, true,
+     " $n $v :Cannot join channel (+k) - bad key"},
+    {IRCCode::NOPRIVILEGES, true,
+     " :Permission Denied- You're not an IRC operator"},
+    {IRCCode::CHANOPRIVSNEEDED, true, " $n $v :You're not channel operator"},
+    {IRCCode::UNKNOWNMODEFLAG, true, " $f :Unknown MODE flag"},
+    {IRCCode::USERSDONTMATCH, true, " :Cant change mode for other users"},
+    {IRCCode::INVALIDMODEPARAM, true, " $n$v : $m"},
+    {IRCCode::INVITENOTICE, true, " :$m"},
+    {IRCCode::TOPICNOTICE, false, ":$v$m"},
+    {IRCCode::MODE, false, ":$v MODE $m"},
+    {IRCCode::KICK, false, ":$v KICK $m"},
+    {IRCCode::PART, false, ":$v PART $m"},
+    {IRCCode::JOIN, false, ":$v JOIN $m"},
+    {IRCCode::NICKCHANGED, false, ":$v NICK $m"},
+    {IRCCode::PRIVMSG, false, ":$v PRIVMSG $m"},
+    {IRCCode::QUIT, false, ":$v QUIT :$m"},
+};
+
+std::size_t indexOf(const IRCCode code) noexcept {
+    return static_cast<std::size_t>(static_cast<std::uint16_t>(code));
+}
+
+std::string paddedCode(const IRCCode code) {
+    std::string digits = std::to_string(static_cast<std::uint16_t>(code));
+    if (digits.length() < 3) {
+        digits.insert(0, 3 - digits.length(), '0');
+    }
+
+    return digits;
+}
+} // namespace
+
+const ReplyCatalog &ReplyCatalog::instance() {
+    static const ReplyCatalog catalog;
+    return catalog;
+}
+
+ReplyCatalog::ReplyCatalog() : _formats(MAX_CODE) {
+    for (const ReplyEntry &entry : ENTRIES) {
+        _compile(entry.code, entry.numeric, entry.format);
+    }
+}
+
+const ReplyFormat *ReplyCatalog::find(const IRCCode code) const noexcept {
+    const std::size_t index = indexOf(code);
+    if (index >= _formats.size() || _formats[index].pieces.empty()) {
+        return nullptr;
+    }
+
+    return &_formats[index];
+}
+
+void ReplyCatalog::_compile(const IRCCode code, const bool numeric,
+                            const char *format) {
+    ReplyFormat &compiled = _formats[indexOf(code)];
+    std::string &text = compiled.text;
+    std::size_t run = 0; // start of the literal run being collected
+
+    if (numeric) {
+        text.append(":").append(serverName).append(" ");
+        text.append(paddedCode(code));
+    }
+
+    const auto flush = [&]() {
+        if (text.size() > run) {
+            compiled.pieces.push_back(
+                ReplyPiece{ReplyPiece::TEXT, static_cast<std::uint16_t>(run),
+                           static_cast<std::uint16_t>(text.size() - run)});
+        }
+        run = text.size();
+    };
+    const auto slot = [&](const ReplyPiece::Kind kind) {
+        flush();
+        compiled.pieces.push_back(ReplyPiece{kind, 0, 0});
+    };
+
+    for (const char *at = format; *at != '\0'; ++at) {
+        if (*at != '$') {
+            text.push_back(*at);
+            continue;
+        }
+
+        ++at;
+        if (*at == 'n') {
+            slot(ReplyPiece::NICK);
+        } else if (*at == '*') {
+            slot(ReplyPiece::NICK_OR_STAR);
+        } else if (*at == 'f') {
+            slot(ReplyPiece::FULL_ID);
+        } else if (*at == 'v') {
+            slot(ReplyPiece::VALUE);
+        } else if (*at == 'm') {
+            slot(ReplyPiece::MSG);
+        } else if (*at == 'S') {
+            text.append(serverName);
+        } else if (*at == 'R') {
+            text.append(serverVersion);
+        } else if (*at == 'L') {
+            text.append(std::to_string(getDefaultValue(Defaults::NICKLEN)));
+        } else if (*at == 'W') {
+            text.append(NAME);
+        }
+    }
+
+    text.append("\r\n");
+    flush();
+}
@@ -1,24 +1,29 @@
 #include <algorithm>
-#include <cctype>
+#include <atomic>
 #include <cerrno>
 #include <chrono>
 #include <csignal>
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <ctime>
 #include <exception>
 #include <functional>
 #include <iostream>
+#include <iterator>
 #include <memory>
+#include <mutex>
 #include <ostream>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <system_error>
+#include <thread>
 #include <utility>
 #include <vector>
 
 #include <arpa/inet.h>
-#include <fcntl.h>
 #include <netinet/in.h>
 #include <signal.h>
 #include <sys/epoll.h>
@@ -30,22 +35,142 @@
 #include "../include/Chatbot.hpp"
 #include "../include/Client.hpp"
 #include "../include/Enums.hpp"
+#include "../include/Logger.hpp"
+#include "../include/LoopMonitor.hpp"
+#include "../include/Reactor.hpp"
 #include "../include/Server.hpp"
+#include "../include/StringView.hpp"
+#include "../include/TimerWheel.hpp"
 #include "../include/Token.hpp"
 #include "../include/Utils.hpp"
 
 namespace {
-bool g_running{true};
+std::atomic<bool> g_running{true};
 void signalHandler(const int signum) {
     if (signum == SIGINT || signum == SIGTERM) {
         g_running = false;
     }
 }
+
+// The reactor whose loop runs on this thread, used by the chatbot to park
+// its API sockets next to the client that asked for them.
+thread_local Reactor *t_reactor{nullptr};
+
+// Milliseconds on the steady clock, wrapping; only differences are used.
+std::uint32_t monotonicMs() noexcept {
+    return static_cast<std::uint32_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+}
+
+// Idle clients are checked twice per idle timeout: silent through one check
+// they are sent a PING, silent through the next they are dropped.
+std::chrono::milliseconds idleCheck(const Config &config) noexcept {
+    return std::chrono::milliseconds(
+        static_cast<std::chrono::milliseconds::rep>(config.idleTimeout * 500));
+}
+
+// Flood tokens a command costs, by how much work and output it causes. A
+// channel message is relayed to every member, so it costs the most.
+std::size_t commandCost(const IRCMessage &token) noexcept {
+    if (token.succes != true) {
+        return 1;
+    }
+
+    switch (token.type) {
+        case IRCCommand::CAP:
+        case IRCCommand::NICK:
+        case IRCCommand::USER:
+        case IRCCommand::PASS:
+        case IRCCommand::QUIT:
+        case IRCCommand::PING:
+        case IRCCommand::PONG:
+        case IRCCommand::UNKNOW:
+            return 1;
+        case IRCCommand::USERHOST:
+        case IRCCommand::WHOIS:
+            return 2;
+        case IRCCommand::JOIN:
+        case IRCCommand::TOPIC:
+        case IRCCommand::PART:
+        case IRCCommand::KICK:
+        case IRCCommand::INVITE:
+        case IRCCommand::MODE:
+            return 3;
+        case IRCCommand::PRIVMSG:
+            return token.params.empty() != true &&
+                           token.params[0].compare(0, 1, "#") == 0
+                       ? 4
+                       : 2;
+    }
+
+    return 1;
+}
 } // namespace
 
-Server::Server(const std::string &port, std::string &password)
+// Routes a reactor's backend events back into the server.
+class Server::ReactorHandler final : public IOHandler {
+  public:
+    ReactorHandler(Server &server, Reactor &reactor)
+        : _server(server), _reactor(reactor) {
+    }
+
+  public:
+    void onAccept(const int fd, const sockaddr_in *peer) override {
+        wake();
+        _server._newConnection(_reactor, fd, peer);
+    }
+
+    void onRecv(const ClientHandle client, const char *data,
+                const std::size_t length) override {
+        wake();
+        _server._clientRecv(_reactor, client, data, length);
+    }
+
+    void onWritable(const ClientHandle client) override {
+        wake();
+        _server._clientSend(_reactor, client);
+    }
+
+    void onClosed(const ClientHandle client) override {
+        wake();
+        _server._clientClosed(_reactor, client);
+    }
+
+    void onAux(const int fd, const std::uint32_t events) override {
+        wake();
+        _server._apiEvent(_reactor, fd, events);
+    }
+
+  public:
+    // When this pass stopped waiting: its first event, which wait() may
+    // handle well before it returns, or the return itself.
+    void wake() noexcept {
+        if (_awake != true) {
+            _woke = std::chrono::steady_clock::now();
+            _awake = true;
+        }
+    }
+
+    std::chrono::microseconds sleep() noexcept {
+        _awake = false;
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - _woke);
+    }
+
+  private:
+    Server &_server;
+    Reactor &_reactor;
+    std::chrono::steady_clock::time_point _woke;
+    bool _awake{false};
+};
+
+Server::Server(const std::string &port, std::string &password,
+               const Config &config)
     : _port(toUint16(port)), _password(std::move(password)), _serverStared(""),
-      _server_fd(-1), _epoll_fd(-1) {
+      _config(config),
+      _invites(std::chrono::milliseconds(getDefaultValue(Defaults::INTERVAL))) {
     if (errno != 0) {
         throw std::invalid_argument("Invalid port");
     }
@@ -78,12 +203,13 @@ Server::Server(const std::string &port, std::string &password)
 
 Server::Server(Server &&rhs) noexcept
     : _port(rhs._port), _password(std::move(rhs._password)),
-      _serverStared(std::move(rhs._serverStared)),
-      _server_fd(std::move(rhs._server_fd)),
-      _epoll_fd(std::move(rhs._epoll_fd)), _connections(rhs._connections),
-      _fd_to_client(std::move(rhs._fd_to_client)),
+      _serverStared(std::move(rhs._serverStared)), _config(rhs._config),
+      _reactors(std::move(rhs._reactors)), _connections(rhs._connections),
+      _clients(std::move(rhs._clients)),
       _nick_to_client(std::move(rhs._nick_to_client)),
-      _channels(std::move(rhs._channels)) {
+      _channels(std::move(rhs._channels)),
+      _lingering(std::move(rhs._lingering)),
+      _invites(std::move(rhs._invites)), _next_sweep(rhs._next_sweep) {
 }
 
 Server &Server::operator=(Server &&rhs) noexcept {
@@ -91,12 +217,15 @@ Server &Server::operator=(Server &&rhs) noexcept {
         _port = rhs._port;
         _password = std::move(rhs._password);
         _serverStared = std::move(rhs._serverStared);
-        _server_fd = std::move(rhs._server_fd);
-        _epoll_fd = std::move(rhs._epoll_fd);
+        _config = rhs._config;
+        _reactors = std::move(rhs._reactors);
         _connections = rhs._connections;
-        _fd_to_client = std::move(rhs._fd_to_client);
+        _clients = std::move(rhs._clients);
         _nick_to_client = std::move(rhs._nick_to_client);
         _channels = std::move(rhs._channels);
+        _lingering = std::move(rhs._lingering);
+        _invites = std::move(rhs._invites);
+        _next_sweep = rhs._next_sweep;
     }
 
     return *this;
@@ -106,21 +235,8 @@ Server::~Server() {
     _shutdown();
 }
 
-void Server::notifyEpollUpdate(const int fd) {
-    const auto it = _fd_to_client.find(fd);
-    if (it == _fd_to_client.end()) {
-        return;
-    }
-
-    epoll_event ev = it->second->getEvent();
-    ev.events = EPOLLIN | EPOLLOUT;
-    if (0 > epoll_ctl(_epoll_fd.get(), EPOLL_CTL_MOD, fd, &ev)) {
-        std::cerr << "Failed to update epoll: " << strerror(errno) << '\n';
-    }
-}
-
 bool Server::init() noexcept {
-    if (_server_fd.get() >= 0 || _epoll_fd.get() >= 0) {
+    if (!_reactors.empty()) {
         std::cerr << "Server already initialized" << '\n';
         return false;
     }
@@ -129,7 +245,7 @@ bool Server::init() noexcept {
 }
 
 bool Server::run() noexcept {
-    if (0 > _server_fd.get() || 0 > _epoll_fd.get()) {
+    if (_reactors.empty()) {
         std::cerr << "Server is not initialized. Call init() first then run()"
                   << '\n';
         return false;
@@ -154,14 +270,39 @@ bool Server::run() noexcept {
         return false;
     }
 
+    std::atomic<bool> failed{false};
+    const auto loop = [this, &failed](Reactor &reactor) {
+        try {
+            _run(reactor);
+        } catch (const ServerException &e) {
+            std::cerr << "Reactor " << reactor.getID() << ": " << e.what()
+                      << '\n';
+            failed = true;
+            g_running = false;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(_reactors.size() - 1);
     try {
-        _run();
-    } catch (const ServerException &e) {
-        std::cerr << e.what() << '\n';
-        return false;
+        for (std::size_t index = 1; index < _reactors.size(); ++index) {
+            threads.emplace_back(loop, std::ref(*_reactors[index]));
+        }
+    } catch (const std::system_error &e) {
+        std::cerr << "Failed to start reactor thread: " << e.what() << '\n';
+        failed = true;
+        g_running = false;
     }
 
-    return true;
+    if (!failed) {
+        loop(*_reactors[0]);
+    }
+
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    return !failed;
 }
 
 const char *Server::ServerException::what() const noexcept {
@@ -176,7 +317,7 @@ std::string Server::getChannelsAndUsers() noexcept {
     std::vector<std::reference_wrapper<Channel>> sortedChannels;
     sortedChannels.reserve(_channels.size());
     for (auto &pair : _channels) {
-        sortedChannels.push_back(std::ref(pair.second));
+        sortedChannels.push_back(std::ref(*pair.second));
     }
 
     std::sort(sortedChannels.begin(), sortedChannels.end(),
@@ -212,218 +353,385 @@ std::string Server::getChannelsAndUsers() noexcept {
     return ss.str();
 }
 
+// One line per registered client, by nick: bytes queued or in flight
+// against its limit, the most it ever had, and the lines it was refused.
+std::string Server::getSendQStats() noexcept {
+    std::vector<std::pair<std::string, Client *>> clients(
+        _nick_to_client.begin(), _nick_to_client.end());
+    std::sort(clients.begin(), clients.end());
+
+    std::stringstream ss;
+    ss << "sendq (queued/limit, peak, dropped lines):\n";
+    for (const auto &entry : clients) {
+        const SendQStats stats = entry.second->getSendQStats();
+        ss << entry.first << ": " << stats.queued << '/';
+        if (stats.limit == 0) {
+            ss << "unlimited";
+        } else {
+            ss << stats.limit;
+        }
+        ss << " B, peak " << stats.peak << " B, dropped " << stats.dropped
+           << "\n";
+    }
+
+    return ss.str();
+}
+
+std::string Server::getLoadStats() const noexcept {
+    std::stringstream ss;
+    ss << "load (tier, lag, backlog, transitions, paused):\n";
+    for (const std::unique_ptr<Reactor> &reactor : _reactors) {
+        const LoadStats stats = reactor->monitor().getStats();
+        ss << "reactor " << reactor->getID() << ": " << toString(stats.tier)
+           << ", " << stats.lagUsec << " us, " << stats.backlog << ", "
+           << stats.transitions << ", " << stats.pausedClients << "\n";
+    }
+
+    return ss.str();
+}
+
+// Whether the calling reactor has turned costly features off.
+bool Server::isShedding() const noexcept {
+    return t_reactor != nullptr &&
+           t_reactor->monitor().getTier() >= OverloadTier::SHED_FEATURES;
+}
+
 int Server::getEpollFD() const noexcept {
-    return _epoll_fd.get();
+    return t_reactor != nullptr ? t_reactor->getEpollFD() : -1;
 }
 
 void Server::addApiRequest(const ApiRequest &api) noexcept {
-    _api_requests[api.fd] = api;
+    if (t_reactor != nullptr) {
+        t_reactor->apiRequests()[api.fd] = api;
+    }
 }
 
 bool Server::_init() noexcept {
     std::srand(static_cast<unsigned int>(std::time(nullptr)));
-    _server_fd = socket(AF_INET, SOCK_STREAM, 0);
-    if (0 > _server_fd.get()) {
-        std::cerr << "Failed to create a socket: " << strerror(errno) << '\n';
-        return false;
-    }
 
-    constexpr int opt = 1;
-    if (0 > setsockopt(_server_fd.get(), SOL_SOCKET, SO_REUSEADDR, &opt,
-                       sizeof(opt))) {
-        std::cerr << "setsockopt failed: " << strerror(errno) << '\n';
-        return false;
-    }
+    _reactors.reserve(_config.threads);
+    for (std::size_t index = 0; index < _config.threads; ++index) {
+        std::unique_ptr<Reactor> reactor(new Reactor(index));
+        if (reactor->init(_port, _config) != true) {
+            _reactors.clear();
+            return false;
+        }
 
-    if (0 > _setNonBlocking(_server_fd.get())) {
-        return false;
+        _reactors.emplace_back(std::move(reactor));
     }
 
-    sockaddr_in address{};
-    address.sin_family = AF_INET;
-    address.sin_addr.s_addr = INADDR_ANY;
-    address.sin_port = htons(_port);
-    if (0 > bind(_server_fd.get(), (sockaddr *)&address, sizeof(address))) {
-        std::cerr << "Bind failed: " << strerror(errno) << '\n';
-        return false;
-    }
+    std::cout << "Server is running on: " << _port << " with "
+              << _reactors.size() << " " << _reactors[0]->backend().getName()
+              << " reactor(s). Press Ctrl+C to stop." << '\n';
+    return true;
+}
 
-    if (0 > listen(_server_fd.get(), SOMAXCONN)) {
-        std::cerr << "Listen failed: " << strerror(errno) << '\n';
-        return false;
-    }
+void Server::_run(Reactor &reactor) {
+    ReactorHandler handler(*this, reactor);
+    t_reactor = &reactor;
 
-    _epoll_fd = epoll_create1(0);
-    if (0 > _epoll_fd.get()) {
-        std::cerr << "Epoll create failed: " << strerror(errno) << '\n';
-        return false;
+    // Each pass reads every ready socket, dispatches what was read under one
+    // state lock, runs the timers that came due, then writes out whatever
+    // was queued. Held lines cut the wait short to when the first of them
+    // becomes affordable, a shedding reactor wakes often enough to notice
+    // the load going down, and armed timers wake it for their next tick.
+    while (g_running) {
+        std::uint32_t timeout = getDefaultValue(Defaults::INTERVAL);
+        if (reactor.monitor().getTier() != OverloadTier::NORMAL) {
+            timeout = getDefaultValue(Defaults::OVERLOAD_TICK);
+        }
+
+        const std::uint32_t now = monotonicMs();
+        for (const Inbound &entry : reactor.held()) {
+            timeout = std::min(
+                timeout, entry.client->tokenDelay(
+                             commandCost(entry.tokens[entry.next]), now));
+        }
+        timeout = static_cast<std::uint32_t>(
+            reactor.timers()
+                .untilTick(std::chrono::steady_clock::now(),
+                           std::chrono::milliseconds(timeout))
+                .count());
+
+        const int ready =
+            reactor.backend().wait(handler, static_cast<int>(timeout));
+        if (0 > ready) {
+            throw ServerException();
+        }
+        handler.wake();
+
+        _dispatch(reactor);
+        _removeClosed(reactor);
+        _runTimers(reactor);
+        if (reactor.getID() == 0) {
+            _sweepChannels();
+        }
+        reactor.backend().flushPending(handler);
+        _reap(reactor);
+        _checkLoad(reactor, handler.sleep(), static_cast<std::size_t>(ready));
     }
 
-    epoll_event ev{};
-    ev.events = EPOLLIN;
-    ev.data.fd = _server_fd.get();
-    if (0 > epoll_ctl(_epoll_fd.get(), EPOLL_CTL_ADD, _server_fd.get(), &ev)) {
-        std::cerr << "Epoll add failed: " << strerror(errno) << '\n';
-        return false;
+    t_reactor = nullptr;
+}
+
+// Destroys the lingering channels nobody rejoined in time and lapses the
+// invites that are due. Runs on reactor 0 at most once per wait interval.
+void Server::_sweepChannels() noexcept {
+    const auto now = std::chrono::steady_clock::now();
+    if (now < _next_sweep) {
+        return;
+    }
+    _next_sweep =
+        now + std::chrono::milliseconds(getDefaultValue(Defaults::INTERVAL));
+
+    const std::chrono::seconds linger(_config.channelLinger);
+    const std::lock_guard<std::mutex> lock(_state_mutex);
+    while (_lingering.empty() != true &&
+           _lingering.front().emptiedAt + linger <= now) {
+        const Lingering entry = std::move(_lingering.front());
+        _lingering.pop_front();
+
+        const auto it = _channels.find(entry.name);
+        if (it != _channels.end() && it->second->getActiveUsers() == 0 &&
+            it->second->getEmptiedAt() == entry.emptiedAt) {
+            _channels.erase(it);
+        }
     }
 
-    std::cout << "Server is running on: " << _port << ". Press Ctrl+C to stop."
-              << '\n';
-    return true;
+    _invites.advance(now, [this](const Invite &invite) {
+        Channel *const channel = isChannel(invite.channel);
+        if (channel != nullptr) {
+            channel->expireInvite(invite.client, invite.generation,
+                                  invite.serial);
+        }
+    });
 }
 
-void Server::_run() {
-    std::vector<epoll_event> events(static_cast<int>(Defaults::EVENT_SIZE));
+// Runs the reactor's client timers that came due. A client has one: its
+// registration deadline at first, then its idle checks, each re-armed by
+// the check before if the client passed it.
+void Server::_runTimers(Reactor &reactor) noexcept {
+    std::unique_lock<std::mutex> lock(_state_mutex, std::defer_lock);
+    const auto drop = [this, &lock](Client *client, const std::string &why) {
+        IRC_LOG(WARN) << "Client FD: " << client->getFD() << " " << why;
+        if (lock.owns_lock() != true) {
+            lock.lock();
+        }
+        _removeClient(client, why);
+    };
 
-    while (g_running) {
-        const int nfds = epoll_wait(
-            _epoll_fd.get(), static_cast<epoll_event *>(events.data()),
-            (int)events.size(), static_cast<int>(Defaults::INTERVAL));
+    const auto fire = [this, &reactor, &drop](const ClientHandle &handle) {
+        Client *const client = _clients.get(handle);
+        if (client == nullptr) {
+            return;
+        }
+        client->setTimer(TimerWheel<ClientHandle>::NONE);
 
-        if (0 > nfds) {
-            if (errno == EINTR) {
-                continue;
-            }
+        if (client->isRegistered() != true &&
+            _config.registrationTimeout != 0) {
+            return drop(client, "Registration timeout");
+        }
+        if (_config.idleTimeout == 0) {
+            return;
+        }
 
-            std::cerr << "Epoll wait failed: " << strerror(errno) << '\n';
-            throw ServerException();
+        const IdleAction action = client->checkIdle();
+        if (action == IdleAction::TIMEOUT) {
+            return drop(client, "Ping timeout: " +
+                                    std::to_string(_config.idleTimeout) +
+                                    " seconds");
         }
 
-        for (int index = 0; index < nfds; ++index) {
-            const auto &event = events[static_cast<std::size_t>(index)];
-
-            if (event.data.fd == _server_fd.get()) {
-                _newConnection();
-            } else if (event.events & EPOLLIN) {
-                auto api_it = _api_requests.find(event.data.fd);
-                if (api_it != _api_requests.end()) {
-                    ApiRequest &current_api_request = api_it->second;
-                    handleRecvApi(current_api_request);
-
-                    if (current_api_request.fd == -1) {
-                        _api_requests.erase(api_it);
-                    } else {
-                        std::cout << "Server::_run: API request for fd="
-                                  << event.data.fd << " waiting for more data."
-                                  << '\n';
-                    }
-                } else {
-                    _clientRecv(event.data.fd);
-                }
-            } else if (event.events & EPOLLOUT) {
-                auto api_it = _api_requests.find(event.data.fd);
-                if (api_it != _api_requests.end()) {
-                    ApiRequest &current_api_request = api_it->second;
-                    if (!handleSendApi(current_api_request, event,
-                                       getEpollFD())) {
-                        if (current_api_request.fd == -1) {
-                            _api_requests.erase(api_it);
-                        }
-                    }
-                } else {
-                    _clientSend(event.data.fd);
-                }
-            } else if (event.events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
-                auto api_it = _api_requests.find(event.data.fd);
-                if (api_it != _api_requests.end()) {
-                    std::cerr << "Server::_run: EPOLLERR/HUP on API socket fd="
-                              << event.data.fd << ". Removing request." << '\n';
-                    if (api_it->second.fd != -1) {
-                        close(api_it->second.fd);
-                        api_it->second.fd = -1;
-                    }
-                    _api_requests.erase(api_it);
-                } else {
-                    auto it = _fd_to_client.find(event.data.fd);
-                    if (it != _fd_to_client.end()) {
-                        std::cerr
-                            << "Server::_run: EPOLLERR/HUP on client socket fd="
-                            << event.data.fd << ". Removing client." << '\n';
-                        _removeClient(it->second);
-                    } else {
-                        std::cerr << "Server::_run: EPOLLERR/HUP on unknown fd="
-                                  << event.data.fd << '\n';
-                        epoll_ctl(_epoll_fd.get(), EPOLL_CTL_DEL, event.data.fd,
-                                  nullptr);
-                    }
-                }
-            } else {
-                std::cout << "Unknown epoll event " << event.events
-                          << " from fd: " << event.data.fd << '\n';
+        if (action == IdleAction::PING) {
+            client->appendMessageToQue(
+                formatMessage(":", serverName, " PING :", serverName));
+        }
+        _armTimer(reactor, client, idleCheck(_config));
+    };
+
+    reactor.timers().advance(std::chrono::steady_clock::now(), fire);
+}
+
+// Owning reactor only; replaces the client's timer.
+void Server::_armTimer(Reactor &reactor, Client *client,
+                       const std::chrono::milliseconds delay) noexcept {
+    if (delay.count() == 0) {
+        return;
+    }
+
+    TimerWheel<ClientHandle> &timers = reactor.timers();
+    timers.cancel(client->getTimer());
+    client->setTimer(TimerWheel<ClientHandle>::NONE);
+    try {
+        client->setTimer(timers.arm(delay, client->getHandle()));
+    } catch (const std::bad_alloc &e) {
+        IRC_LOG(ERROR) << "Failed to arm timer: " << e.what();
+    }
+}
+
+// Feeds a finished pass to the reactor's LoopMonitor and carries out a tier
+// change. Heavy senders are paused by _dispatch while at PAUSE_HEAVY or
+// above, and the bot checks isShedding() itself.
+void Server::_checkLoad(Reactor &reactor, const std::chrono::microseconds busy,
+                        const std::size_t ready) noexcept {
+    LoopMonitor &monitor = reactor.monitor();
+    const OverloadTier before = monitor.getTier();
+    const std::size_t backlog = ready + reactor.held().size();
+    if (monitor.sample(std::chrono::steady_clock::now(), busy, backlog) !=
+        true) {
+        return;
+    }
+
+    const OverloadTier tier = monitor.getTier();
+    IRC_LOG(INFO) << "Reactor " << reactor.getID() << ": load "
+                  << toString(before) << " -> " << toString(tier) << " (lag "
+                  << monitor.getStats().lagUsec << " us, backlog " << backlog
+                  << ")";
+
+    reactor.backend().deferAccept(tier >= OverloadTier::DEFER_ACCEPT);
+    if (tier < OverloadTier::PAUSE_HEAVY) {
+        for (const ClientHandle &handle : reactor.paused()) {
+            Client *const client = _clients.get(handle);
+            if (client != nullptr) {
+                _pauseRecv(reactor, client, Client::PAUSE_OVERLOAD, false);
             }
         }
+        reactor.paused().clear();
     }
 }
 
 void Server::_shutdown() noexcept {
     std::cout << '\n' << "Shutting down server..." << '\n';
 
-    std::vector<std::shared_ptr<Client>> clients_to_remove;
-    clients_to_remove.reserve(_fd_to_client.size());
-    for (const auto &pair : _fd_to_client) {
-        clients_to_remove.push_back(pair.second);
+    const std::lock_guard<std::mutex> lock(_state_mutex);
+    for (const std::unique_ptr<Reactor> &reactor : _reactors) {
+        const IOStats stats = reactor->backend().getStats();
+        const LoadStats load = reactor->monitor().getStats();
+        std::cout << "Reactor " << reactor->getID() << ": accepted "
+                  << stats.accepted << ", accept failures "
+                  << stats.acceptFailed << ", shed " << stats.acceptShed
+                  << ", load transitions " << load.transitions
+                  << ", paused for load " << load.pausedClients << '\n';
+
+        reactor->apiRequests().clear();
+        reactor->inbox().clear();
+        reactor->held().clear();
+        reactor->paused().clear();
     }
 
-    for (const auto &client : clients_to_remove) {
-        _removeClient(client);
+    for (std::size_t fd = 0; fd < _clients.capacity(); ++fd) {
+        Client *client = _clients.get(static_cast<int>(fd));
+        if (client != nullptr) {
+            _removeClient(client);
+        }
+    }
+
+    for (const std::unique_ptr<Reactor> &reactor : _reactors) {
+        _reap(*reactor);
     }
 
-    _fd_to_client.clear();
     _nick_to_client.clear();
+    _lingering.clear();
     _channels.clear();
-    _api_requests.clear();
 }
 
-int Server::_setNonBlocking(const int fd) noexcept {
-    const int returnCode = fcntl(fd, F_SETFL, O_NONBLOCK);
-    if (0 > returnCode) {
-        std::cerr << "Failed to set to non-blocking mode: " << strerror(errno)
-                  << '\n';
+// Runs at the end of a loop pass, when nothing from that pass can still
+// refer to the clients it removed.
+// Removes the clients that hung up during wait(), once the dispatch phase
+// had its go at what they sent before, e.g. a final QUIT. Lines it left
+// held are dropped with them, as for any removed client.
+void Server::_removeClosed(Reactor &reactor) noexcept {
+    std::vector<ClientHandle> &closed = reactor.closed();
+    if (closed.empty()) {
+        return;
     }
 
-    return returnCode;
+    const std::lock_guard<std::mutex> lock(_state_mutex);
+    for (const ClientHandle &handle : closed) {
+        Client *const client = _clients.get(handle);
+        if (client != nullptr) {
+            _removeClient(client);
+        }
+    }
+    closed.clear();
 }
 
-void Server::_newConnection() noexcept {
+void Server::_reap(Reactor &reactor) noexcept {
+    std::vector<Inbound> &held = reactor.held();
+    if (held.empty() != true && reactor.retired().empty() != true) {
+        held.erase(std::remove_if(held.begin(), held.end(),
+                                  [this](const Inbound &entry) {
+                                      return _clients.get(
+                                                 entry.client->getFD()) !=
+                                             entry.client;
+                                  }),
+                   held.end());
+    }
+
+    for (const int fd : reactor.retired()) {
+        _clients.destroy(fd);
+    }
+    reactor.retired().clear();
+}
+
+void Server::_newConnection(Reactor &reactor, const int clientFD,
+                            const sockaddr_in *peer) noexcept {
     sockaddr_in clientAddr{};
     socklen_t clientLen = sizeof(clientAddr);
 
-    int clientFD =
-        accept(_server_fd.get(), reinterpret_cast<sockaddr *>(&clientAddr),
-               &clientLen);
-
-    if (0 > clientFD) {
-        std::cerr << "Accept failed: " << strerror(errno) << '\n';
+    if (peer != nullptr) {
+        clientAddr = *peer;
+    } else if (0 > getpeername(clientFD,
+                               reinterpret_cast<sockaddr *>(&clientAddr),
+                               &clientLen)) {
+        IRC_LOG(ERROR) << "getpeername failed: " << strerror(errno);
+        close(clientFD);
         return;
     }
 
-    if (0 > _setNonBlocking(clientFD)) {
+    Client *client = nullptr;
+    try {
+        client = _clients.create(clientFD);
+    } catch (const std::bad_alloc &e) {
+        IRC_LOG(ERROR) << "Failed to allocate client: " << e.what();
+    }
+
+    if (client == nullptr) {
         close(clientFD);
         return;
     }
 
-    const std::shared_ptr<Client> client = std::make_shared<Client>(clientFD);
-    client->setEpollNotifier(this);
-    if (0 > epoll_ctl(_epoll_fd.get(), EPOLL_CTL_ADD, clientFD,
-                      &client->getEvent())) {
-        std::cerr << "Failed to add client to epoll" << '\n';
+    client->setEpollNotifier(&reactor.backend());
+    client->setReactor(reactor.getID());
+    client->setConnectionClass(&_config.unregistered, monotonicMs());
+    if (reactor.backend().addClient(client->getHandle()) != true) {
+        _clients.destroy(clientFD);
         return;
     }
 
     client->setIP(inet_ntoa(clientAddr.sin_addr));
-    _fd_to_client[clientFD] = client;
-    _connections = _fd_to_client.size();
+    if (_config.registrationTimeout != 0) {
+        _armTimer(reactor, client,
+                  std::chrono::seconds(_config.registrationTimeout));
+    } else {
+        _armTimer(reactor, client, idleCheck(_config));
+    }
 
-    std::cout << "New client connected on fd " << clientFD << '\n';
+    const std::lock_guard<std::mutex> lock(_state_mutex);
+    ++_connections;
+
+    IRC_LOG(INFO) << "New client connected on fd " << clientFD << " (reactor "
+                  << reactor.getID() << ")";
 }
 
-void Server::_clientAccepted(const std::shared_ptr<Client> &client) noexcept {
+void Server::_clientAccepted(Client *client) noexcept {
     if (client->isRegistered() != true) {
         return;
     }
 
     const int clientFD = client->getFD();
     const std::string nick = client->getNickname();
+    client->setConnectionClass(&_config.registered, monotonicMs());
     handleMsg(IRCCode::WELCOME, client, "", "");
     handleMsg(IRCCode::YOURHOST, client, "", "");
     handleMsg(IRCCode::CREATED, client, "", _serverStared);
@@ -436,85 +744,166 @@ void Server::_clientAccepted(const std::shared_ptr<Client> &client) noexcept {
     handleMsg(IRCCode::ENDOFMOTD, client, "", "");
 
     _nick_to_client[nick] = client;
-    std::cerr << "Client on fd: " << clientFD << " is accepted" << '\n';
+    IRC_LOG(INFO) << "Client on fd: " << clientFD << " is accepted";
 }
 
-void Server::_clientRecv(const int fd) noexcept {
-    const std::shared_ptr<Client> client = _fd_to_client[fd];
-    if (!client) {
+void Server::_clientRecv(Reactor &reactor, const ClientHandle handle,
+                         const char *data, const std::size_t length) noexcept {
+    Client *const client = _clients.get(handle);
+    if (client == nullptr || client->getReactor() != reactor.getID()) {
         return;
     }
 
-    char buffer[static_cast<int>(Defaults::READ_SIZE) + 1] = {};
-    const ssize_t bytes_read =
-        recv(fd, buffer, static_cast<int>(Defaults::READ_SIZE), MSG_DONTWAIT);
-    if (0 > bytes_read) {
-        if (errno == EAGAIN) {
-            return;
-        }
+    client->markHeard();
+    IRC_LOG(TRACE) << "recv from fd: " << client->getFD() << ": "
+                   << StringView(data, length);
 
-        _removeClient(client);
-        std::cerr << "Error while recv: " << strerror(errno) << '\n';
-        return;
+    std::vector<Inbound> &inbox = reactor.inbox();
+    if (inbox.empty() || inbox.back().client != client) {
+        inbox.push_back(Inbound{client, {}, 0});
     }
+    std::vector<IRCMessage> &tokens = inbox.back().tokens;
+
+    // Lines are framed and parsed straight out of the backend's read
+    // buffer; the client only keeps an unterminated tail.
+    client->getInput().feed(
+        data, length,
+        [&client, &tokens](const char *line, const std::size_t size,
+                           const bool tooLong) {
+            if (tooLong) {
+                IRCMessage msg = {};
+                msg.succes = false;
+                msg.err.set_value(IRCCode::INPUTTOOLONG);
+                tokens.emplace_back(msg);
+                return;
+            }
+
+            if (size == 0) {
+                return;
+            }
+
+            IRC_LOG(TRACE) << "message from fd: " << client->getFD() << ": "
+                           << StringView(line, size);
+
+            tokens.emplace_back();
+            if (parseIRCMessage(line, size, tokens.back()) != true) {
+                tokens.pop_back();
+            }
+        });
 
-    if (bytes_read == 0) {
-        _removeClient(client);
+    if (inbox.back().tokens.empty()) {
+        inbox.pop_back();
+    }
+}
+
+// Marks are queued by handle, from any thread, and may outlive the
+// connection they were made for; a client that went away, or whose fd now
+// belongs to another reactor's connection, is skipped.
+void Server::_clientSend(Reactor &reactor,
+                         const ClientHandle handle) noexcept {
+    Client *const client = _clients.get(handle);
+    if (client == nullptr || client->getReactor() != reactor.getID()) {
         return;
     }
 
-    std::cout << "recv from fd: " << client->getFD() << ": " << buffer << '\n';
-    client->appendToBuffer(std::string(buffer, (std::size_t)bytes_read));
-    _processMessage(client);
+    const int fd = handle.fd;
+
+    const FlushResult result = reactor.backend().flush(*client);
+    if (result == FlushResult::FAILED ||
+        (result == FlushResult::DONE && client->isDisconnect())) {
+        const std::lock_guard<std::mutex> lock(_state_mutex);
+        return _removeClient(client);
+    }
+
+    const SendQAction action = client->checkSendQ();
+    if (action == SendQAction::EVICT) {
+        IRC_LOG(WARN) << "Client FD: " << fd << " SendQ exceeded";
+        const std::lock_guard<std::mutex> lock(_state_mutex);
+        _removeClient(client, "SendQ exceeded");
+    } else if (action == SendQAction::DROP) {
+        IRC_LOG(WARN) << "Client FD: " << fd << " SendQ full, dropping";
+    } else if (action == SendQAction::PAUSE) {
+        IRC_LOG(WARN) << "Client FD: " << fd << " SendQ full, pausing";
+        _pauseRecv(reactor, client, Client::PAUSE_SENDQ, true);
+    } else if (action == SendQAction::RESUME) {
+        IRC_LOG(INFO) << "Client FD: " << fd << " SendQ drained";
+        _pauseRecv(reactor, client, Client::PAUSE_SENDQ, false);
+    }
 }
 
-void Server::_clientSend(const int fd) noexcept {
-    const std::shared_ptr<Client> client = _fd_to_client[fd];
+void Server::_clientClosed(Reactor &reactor,
+                           const ClientHandle handle) noexcept {
+    Client *const client = _clients.get(handle);
+    if (client == nullptr || client->getReactor() != reactor.getID()) {
+        return;
+    }
 
-    while (client->haveMessagesToSend()) {
-        const std::string msg = client->getMessage();
+    // Removed after the dispatch phase, so commands read before the hangup
+    // still count without dispatching from inside wait().
+    reactor.closed().push_back(handle);
+}
 
-        const std::size_t offset = client->getOffset();
-        std::cout << "send to fd: " << client->getFD() << ": " << msg.c_str()
-                  << '\n';
-        const ssize_t bytes =
-            send(client->getFD(), msg.c_str() + offset, msg.length() - offset,
-                 MSG_DONTWAIT | MSG_NOSIGNAL);
+void Server::_apiEvent(Reactor &reactor, const int fd,
+                       const std::uint32_t events) noexcept {
+    std::unordered_map<int, ApiRequest> &apiRequests = reactor.apiRequests();
+    const auto api_it = apiRequests.find(fd);
 
-        if (0 > bytes) {
-            if (errno == EAGAIN) {
-                break;
-            }
+    if (api_it == apiRequests.end()) {
+        IRC_LOG(WARN) << "Server::_apiEvent: event " << events
+                      << " on unknown fd=" << fd;
+        epoll_ctl(reactor.getEpollFD(), EPOLL_CTL_DEL, fd, nullptr);
+        return;
+    }
 
-            std::cerr << "Error while sending: " << strerror(errno) << '\n';
-            _removeClient(client);
-            break;
+    ApiRequest &current_api_request = api_it->second;
+    Client *const client = _clients.get(current_api_request.client);
+    if (client == nullptr) {
+        IRC_LOG(INFO) << "Server::_apiEvent: client for API fd=" << fd
+                      << " is gone. Removing request.";
+        epoll_ctl(reactor.getEpollFD(), EPOLL_CTL_DEL, fd, nullptr);
+        if (current_api_request.fd != -1) {
+            close(current_api_request.fd);
         }
+        apiRequests.erase(api_it);
+        return;
+    }
 
-        client->setOffset(static_cast<std::size_t>(bytes));
-        if (client->getOffset() >= msg.length()) {
-            client->removeMessage();
+    if (events & EPOLLIN) {
+        const std::lock_guard<std::mutex> lock(_state_mutex);
+        handleRecvApi(current_api_request, client);
+
+        if (current_api_request.fd == -1) {
+            apiRequests.erase(api_it);
         } else {
-            break;
+            IRC_LOG(TRACE) << "Server::_apiEvent: API request for fd=" << fd
+                           << " waiting for more data.";
         }
-    }
-
-    epoll_event ev = client->getEvent();
-    if (client->haveMessagesToSend() != true) {
-        ev.events = EPOLLIN;
-        if (epoll_ctl(_epoll_fd.get(), EPOLL_CTL_MOD, client->getFD(), &ev) ==
-            -1) {
-            std::cerr << "Failed to update epoll event: " << strerror(errno)
-                      << '\n';
+    } else if (events & EPOLLOUT) {
+        epoll_event event{};
+        event.events = events;
+        event.data.fd = fd;
+
+        const std::lock_guard<std::mutex> lock(_state_mutex);
+        if (!handleSendApi(current_api_request, client, event,
+                           reactor.getEpollFD())) {
+            if (current_api_request.fd == -1) {
+                apiRequests.erase(api_it);
+            }
         }
-
-        if (client->isDisconnect()) {
-            _removeClient(client);
+    } else if (events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+        IRC_LOG(WARN) << "Server::_apiEvent: EPOLLERR/HUP on API socket fd="
+                      << fd << ". Removing request.";
+        if (current_api_request.fd != -1) {
+            close(current_api_request.fd);
+            current_api_request.fd = -1;
         }
+        apiRequests.erase(api_it);
     }
 }
 
-void Server::_removeClient(const std::shared_ptr<Client> &client) noexcept {
+// Caller holds _state_mutex, on the client's reactor or after they stopped.
+void Server::_removeClient(Client *client,
+                           const std::string &reason) noexcept {
     if (!client) {
         return;
     }
@@ -523,80 +912,270 @@ void Server::_removeClient(const std::shared_ptr<Client> &client) noexcept {
     const std::string &nickname = client->getNickname();
 
     try {
-        const auto fd_it = _fd_to_client.find(fd);
+        Reactor &reactor = *_reactors[client->getReactor()];
         const auto nick_it = _nick_to_client.find(nickname);
 
-        if (fd_it != _fd_to_client.end() && fd_it->second == client) {
-            _fd_to_client.erase(fd_it);
-            epoll_ctl(_epoll_fd.get(), EPOLL_CTL_DEL, fd, nullptr);
-            _connections = _fd_to_client.size();
+        // Retired, not destroyed: the inbox or the flush list of this pass
+        // may still point at it. _reap frees the slot once the pass ends.
+        if (_clients.get(fd) == client) {
+            _clients.retire(fd);
+            reactor.retired().push_back(fd);
+            reactor.backend().removeClient(fd);
+            reactor.timers().cancel(client->getTimer());
+            client->setTimer(TimerWheel<ClientHandle>::NONE);
+            _dropInbound(reactor, client);
+            --_connections;
         }
 
         if (nick_it != _nick_to_client.end() && nick_it->second == client) {
             _nick_to_client.erase(nick_it);
         }
 
-        const std::vector<std::string> &channels = client->allChannels();
-        for (const std::string &channel : channels) {
-            auto it = _channels.find(channel);
-            if (it != _channels.end()) {
-                it->second.removeUser(client, "");
-            }
+        // One QUIT per peer however many channels they share, then leave
+        // those channels without a PART each.
+        _sendToPeers(client,
+                     makePayload(formatRelay(
+                         IRCCode::QUIT, client->getFullID(),
+                         reason.empty() ? "Connection closed" : reason)));
+        while (client->getChannels().empty() != true) {
+            Channel *channel = client->getChannels().back();
+            channel->quitUser(client);
+            _releaseIfEmpty(channel);
         }
 
-        std::cout << "Client FD: " << fd << " disconnected" << '\n';
+        IRC_LOG(INFO) << "Client FD: " << fd << " disconnected";
     } catch (const std::exception &e) {
-        std::cerr << "Error while removing client - FD: " << fd
-                  << " Nickname: '" << nickname << "' - " << e.what() << '\n';
+        IRC_LOG(ERROR) << "Error while removing client - FD: " << fd
+                       << " Nickname: '" << nickname << "' - " << e.what();
+    }
+}
+
+// Owning reactor only. Commands read from a removed client must not run:
+// they would link it back into channels and the nick table. Its inbox
+// entries go at once; its held entry may be the one being dispatched, and
+// a QUIT may still be using its tokens, so that is only marked done and
+// goes when _dispatch or _reap next compacts the held list.
+void Server::_dropInbound(Reactor &reactor, const Client *client) noexcept {
+    std::vector<Inbound> &inbox = reactor.inbox();
+    inbox.erase(std::remove_if(inbox.begin(), inbox.end(),
+                               [client](const Inbound &entry) {
+                                   return entry.client == client;
+                               }),
+                inbox.end());
+
+    for (Inbound &entry : reactor.held()) {
+        if (entry.client == client) {
+            entry.next = entry.tokens.size();
+            break;
+        }
     }
 }
 
 Channel *Server::isChannel(const std::string &channelName) noexcept {
-    std::string channelUpper = channelName;
-    std::transform(channelUpper.begin(), channelUpper.end(),
-                   channelUpper.begin(), ::toupper);
+    const auto it = _channels.find(channelName);
+    if (it == _channels.end()) {
+        return nullptr;
+    }
+
+    return it->second.get();
+}
 
-    for (auto &it : _channels) {
-        std::string uppercaseIt = it.first;
-        std::transform(uppercaseIt.begin(), uppercaseIt.end(),
-                       uppercaseIt.begin(), ::toupper);
-        if (uppercaseIt == channelUpper) {
-            return &it.second;
+// Called once a member left: an empty channel is destroyed, or kept for
+// channelLinger seconds when it has modes worth keeping.
+void Server::_releaseIfEmpty(Channel *channel) noexcept {
+    if (channel->getActiveUsers() != 0) {
+        return;
+    }
+
+    if (channel->hasPersistentModes() && _config.channelLinger != 0) {
+        const auto now = std::chrono::steady_clock::now();
+        channel->setEmptiedAt(now);
+        _lingering.push_back(Lingering{channel->getName(), now});
+        return;
+    }
+
+    const auto it = _channels.find(channel->getName());
+    if (it != _channels.end()) {
+        _channels.erase(it);
+    }
+}
+
+// Everyone who shares at least one channel with `client`, once each, in
+// time linear in the size of those channels: a client counts as seen when
+// it carries this pass's epoch. The epoch is 64 bits wide so it never wraps:
+// resetting every client's mark would touch clients that other reactors
+// create and destroy without holding the state lock.
+const std::vector<Client *> &Server::_collectPeers(Client *client) noexcept {
+    _peers.clear();
+
+    ++_fanout_epoch;
+    client->markFanout(_fanout_epoch);
+    for (const Channel *channel : client->getChannels()) {
+        for (const Member &member : channel->getMembers()) {
+            if (member.client->markFanout(_fanout_epoch)) {
+                _peers.push_back(member.client);
+            }
         }
     }
 
-    return nullptr;
+    return _peers;
 }
 
-void Server::_processMessage(const std::shared_ptr<Client> &client) noexcept {
-    while (client->hasCompleteMessage()) {
+void Server::_sendToPeers(Client *client, const Payload &payload) noexcept {
+    for (Client *peer : _collectPeers(client)) {
+        peer->appendPayload(payload);
+    }
+}
 
-        const std::string msg = client->getAndClearBuffer();
+// Owning reactor only. Reads stop while any reason holds and resume once
+// none does.
+void Server::_pauseRecv(Reactor &reactor, Client *client,
+                        const Client::RecvPause reason,
+                        const bool paused) noexcept {
+    if (client->setRecvPaused(reason, paused)) {
+        reactor.backend().pauseRecv(client->getFD(), paused);
+    }
+}
 
-        if (msg == "") {
-            return;
+// Clients with commands take turns of up to dispatchTurn commands, round
+// after round, until all are handled or the pass has used its time budget.
+// A client left with commands, for want of time or of flood tokens, keeps
+// them in held and is not read again until they are through: its backlog
+// waits in its own socket buffer, and every other client still gets a turn
+// in each pass. The next pass starts its round where this one stopped.
+void Server::_dispatch(Reactor &reactor) noexcept {
+    std::vector<Inbound> &inbox = reactor.inbox();
+    std::vector<Inbound> &held = reactor.held();
+    if (inbox.empty() && held.empty()) {
+        return;
+    }
+
+    // What a client sent goes behind what it already has waiting. Lines
+    // from a client removed since they were read are dropped.
+    for (Inbound &entry : inbox) {
+        Client *const client = entry.client;
+        if (_clients.get(client->getFD()) != client) {
+            continue;
+        }
+
+        if (client->isScheduled() != true) {
+            client->setScheduled(true);
+            held.push_back(std::move(entry));
+            continue;
         }
 
-        if (msg.length() > getDefaultValue(Defaults::MAXMSGLEN)) {
-            handleMsg(IRCCode::INPUTTOOLONG, client, "", "");
+        for (auto it = held.rbegin(); it != held.rend(); ++it) {
+            if (it->client == client) {
+                std::move(entry.tokens.begin(), entry.tokens.end(),
+                          std::back_inserter(it->tokens));
+                break;
+            }
+        }
+    }
+    inbox.clear();
+
+    const auto start = std::chrono::steady_clock::now();
+    const std::chrono::microseconds budget(_config.dispatchBudget);
+    const std::uint32_t now = monotonicMs();
+    std::size_t resume = 0;
+
+    const std::lock_guard<std::mutex> lock(_state_mutex);
+    bool again = true;
+    while (again) {
+        again = false;
+        for (std::size_t i = 0; i < held.size(); ++i) {
+            Inbound &entry = held[i];
+            if (_clients.get(entry.client->getFD()) != entry.client) {
+                entry.next = entry.tokens.size();
+            }
+            if (entry.next == entry.tokens.size()) {
+                continue;
+            }
+
+            const std::size_t handled =
+                _dispatchMessages(entry, _config.dispatchTurn, now);
+            if (handled == _config.dispatchTurn &&
+                entry.next != entry.tokens.size()) {
+                again = true;
+            }
+
+            if (budget.count() != 0 &&
+                std::chrono::steady_clock::now() - start >= budget) {
+                resume = i + 1;
+                again = false;
+                break;
+            }
+        }
+    }
+
+    // Whoever is left more than a turn behind is a heavy sender; past
+    // PAUSE_HEAVY they are not read again until the load is down, even once
+    // their lines are through.
+    const bool shedding =
+        reactor.monitor().getTier() >= OverloadTier::PAUSE_HEAVY;
+    std::rotate(held.begin(),
+                held.begin() + static_cast<std::ptrdiff_t>(resume),
+                held.end());
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < held.size(); ++i) {
+        Inbound &entry = held[i];
+        Client *const client = entry.client;
+        if (_clients.get(client->getFD()) != client) {
+            client->setScheduled(false);
             continue;
         }
 
-        std::cout << "message from fd: " << client->getFD() << ": " << msg << '\n';
-        const std::vector<IRCMessage> clientsToken = parseIRCMessage(msg);
-        for (const IRCMessage &token : clientsToken) {
-            if (!token.succes) {
-                try {
-                    handleMsg(token.err.get_value(), client, token.errMsg,
-                              "Unknow command");
-                } catch (std::runtime_error &e) {
-                    std::cerr << "Failed to get value from err: " << e.what()
-                              << '\n';
-                    return;
-                }
-            } else {
-                _handleCommand(token, client);
+        if (entry.next == entry.tokens.size()) {
+            client->setScheduled(false);
+            _pauseRecv(reactor, client, Client::PAUSE_HELD, false);
+            continue;
+        }
+
+        _pauseRecv(reactor, client, Client::PAUSE_HELD, true);
+        if (shedding &&
+            entry.tokens.size() - entry.next > _config.dispatchTurn &&
+            client->isRecvPaused(Client::PAUSE_OVERLOAD) != true) {
+            IRC_LOG(WARN) << "Client FD: " << client->getFD()
+                          << " paused, reactor overloaded";
+            _pauseRecv(reactor, client, Client::PAUSE_OVERLOAD, true);
+            reactor.paused().push_back(client->getHandle());
+            reactor.monitor().pausedClient();
+        }
+        if (kept != i) {
+            held[kept] = std::move(entry);
+        }
+        ++kept;
+    }
+    held.erase(held.begin() + static_cast<std::ptrdiff_t>(kept), held.end());
+}
+
+// One turn: handles up to `turn` of the entry's commands and returns how
+// many. It stops early at a command the client cannot afford.
+std::size_t Server::_dispatchMessages(Inbound &entry, const std::size_t turn,
+                                      const std::uint32_t now) noexcept {
+    Client *const client = entry.client;
+    std::size_t handled = 0;
+    while (handled < turn && entry.next < entry.tokens.size()) {
+        const IRCMessage &token = entry.tokens[entry.next];
+        if (client->spendTokens(commandCost(token), now) != true) {
+            break;
+        }
+
+        ++entry.next;
+        ++handled;
+        if (!token.succes) {
+            try {
+                handleMsg(token.err.get_value(), client, token.errMsg,
+                          "Unknow command");
+            } catch (std::runtime_error &e) {
+                IRC_LOG(ERROR) << "Failed to get value from err: " << e.what();
+                entry.next = entry.tokens.size();
+                break;
             }
+        } else {
+            _handleCommand(token, client);
         }
     }
+
+    return handled;
 }
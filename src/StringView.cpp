@@ -0,0 +1,36 @@
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+#include "../include/StringView.hpp"
+
+StringView::StringView() noexcept : _data(""), _size(0) {
+}
+
+StringView::StringView(const char *data, const std::size_t size) noexcept
+    : _data(data), _size(size) {
+}
+
+const char *StringView::data() const noexcept {
+    return _data;
+}
+
+std::size_t StringView::size() const noexcept {
+    return _size;
+}
+
+bool StringView::empty() const noexcept {
+    return _size == 0;
+}
+
+char StringView::operator[](const std::size_t index) const noexcept {
+    return _data[index];
+}
+
+bool StringView::equals(const char *str, const std::size_t size) const noexcept {
+    return _size == size && std::memcmp(_data, str, size) == 0;
+}
+
+std::string StringView::str() const {
+    return std::string(_data, _size);
+}
@@ -1,35 +1,66 @@
 #include <algorithm>
+#include <cstddef>
 #include <cstdlib>
-#include <iostream>
-#include <sstream>
-#include <stdexcept>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
 #include "../include/Chatbot.hpp"
 #include "../include/Enums.hpp"
+#include "../include/StringView.hpp"
 #include "../include/Token.hpp"
 #include "../include/Utils.hpp"
 
 namespace {
-IRCCommand getCommand(const std::string &command) {
-    static const std::unordered_map<std::string, IRCCommand> commandMap = {
-        {"CAP", IRCCommand::CAP},         {"NICK", IRCCommand::NICK},
-        {"USER", IRCCommand::USER},       {"PASS", IRCCommand::PASS},
-        {"PRIVMSG", IRCCommand::PRIVMSG}, {"JOIN", IRCCommand::JOIN},
-        {"TOPIC", IRCCommand::TOPIC},     {"PART", IRCCommand::PART},
-        {"QUIT", IRCCommand::QUIT},       {"PING", IRCCommand::PING},
-        {"KICK", IRCCommand::KICK},       {"INVITE", IRCCommand::INVITE},
-        {"MODE", IRCCommand::MODE},       {"USERHOST", IRCCommand::USERHOST},
-        {"UNKNOW", IRCCommand::UNKNOW},   {"WHOIS", IRCCommand::WHOIS}};
-
-    const auto it = commandMap.find(command);
-    if (it == commandMap.end()) {
-        return IRCCommand::UNKNOW;
-    }
-
-    return it->second;
+struct CommandName {
+    const char *name;
+    std::size_t size;
+    IRCCommand type;
+};
+
+// Looked up straight from the receive buffer, so a command name is never
+// copied just to be classified.
+IRCCommand getCommand(const StringView &command) noexcept {
+    static const CommandName commands[] = {
+        {"PRIVMSG", 7, IRCCommand::PRIVMSG}, {"PING", 4, IRCCommand::PING},
+        {"JOIN", 4, IRCCommand::JOIN},       {"PART", 4, IRCCommand::PART},
+        {"MODE", 4, IRCCommand::MODE},       {"TOPIC", 5, IRCCommand::TOPIC},
+        {"NICK", 4, IRCCommand::NICK},       {"USER", 4, IRCCommand::USER},
+        {"PASS", 4, IRCCommand::PASS},       {"QUIT", 4, IRCCommand::QUIT},
+        {"KICK", 4, IRCCommand::KICK},       {"INVITE", 6, IRCCommand::INVITE},
+        {"CAP", 3, IRCCommand::CAP},         {"USERHOST", 8, IRCCommand::USERHOST},
+        {"WHOIS", 5, IRCCommand::WHOIS},     {"PONG", 4, IRCCommand::PONG},
+        {"UNKNOW", 6, IRCCommand::UNKNOW}};
+
+    for (const CommandName &entry : commands) {
+        if (command.equals(entry.name, entry.size)) {
+            return entry.type;
+        }
+    }
+
+    return IRCCommand::UNKNOW;
+}
+
+bool isSpace(const char c) noexcept {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' ||
+           c == '\r';
+}
+
+std::size_t skipSpaces(const char *line, std::size_t pos,
+                       const std::size_t length) noexcept {
+    while (pos < length && isSpace(line[pos])) {
+        ++pos;
+    }
+
+    return pos;
+}
+
+std::size_t skipWord(const char *line, std::size_t pos,
+                     const std::size_t length) noexcept {
+    while (pos < length && isSpace(line[pos]) != true) {
+        ++pos;
+    }
+
+    return pos;
 }
 
 void isValidNick(IRCMessage &token) {
@@ -254,102 +285,119 @@ void isValidKick(IRCMessage &token) {
     }
 }
 
-void validateMessage(std::vector<IRCMessage> &tokens) {
-    for (auto &&token : tokens) {
-        switch (token.type) {
-            case IRCCommand::NICK:
-                isValidNick(token);
-                break;
-            case IRCCommand::USER:
-                isValidUsername(token);
-                break;
-            case IRCCommand::KICK:
-                isValidKick(token);
-                break;
-            case IRCCommand::INVITE:
-            case IRCCommand::PRIVMSG:
-                if (token.params.size() < 2) {
-                    token.err.set_value(IRCCode::NEEDMOREPARAMS);
-                    token.errMsg = token.command;
-                    token.succes = false;
-                }
-                break;
-            case IRCCommand::TOPIC:
-                isValidTopic(token);
-                break;
-            case IRCCommand::JOIN:
-                isValidJoin(token);
-                break;
-            case IRCCommand::PART:
-                isValidPart(token);
-                break;
-            case IRCCommand::PASS:
-            case IRCCommand::QUIT:
-            case IRCCommand::PING:
-            case IRCCommand::USERHOST:
-                if (token.params.size() < 1) {
-                    token.err.set_value(IRCCode::NEEDMOREPARAMS);
-                    token.errMsg = token.command;
-                    token.succes = false;
-                }
-                break;
-            case IRCCommand::MODE:
-                isValidMode(token);
-                break;
-            case IRCCommand::UNKNOW:
-                token.err.set_value(IRCCode::UNKNOWNCOMMAND);
+void validateMessage(IRCMessage &token) {
+    switch (token.type) {
+        case IRCCommand::NICK:
+            isValidNick(token);
+            break;
+        case IRCCommand::USER:
+            isValidUsername(token);
+            break;
+        case IRCCommand::KICK:
+            isValidKick(token);
+            break;
+        case IRCCommand::INVITE:
+        case IRCCommand::PRIVMSG:
+            if (token.params.size() < 2) {
+                token.err.set_value(IRCCode::NEEDMOREPARAMS);
                 token.errMsg = token.command;
                 token.succes = false;
-                break;
-            case IRCCommand::CAP:
-            case IRCCommand::WHOIS:
-                break;
-        }
+            }
+            break;
+        case IRCCommand::TOPIC:
+            isValidTopic(token);
+            break;
+        case IRCCommand::JOIN:
+            isValidJoin(token);
+            break;
+        case IRCCommand::PART:
+            isValidPart(token);
+            break;
+        case IRCCommand::PASS:
+        case IRCCommand::QUIT:
+        case IRCCommand::PING:
+        case IRCCommand::USERHOST:
+            if (token.params.size() < 1) {
+                token.err.set_value(IRCCode::NEEDMOREPARAMS);
+                token.errMsg = token.command;
+                token.succes = false;
+            }
+            break;
+        case IRCCommand::MODE:
+            isValidMode(token);
+            break;
+        case IRCCommand::UNKNOW:
+            token.err.set_value(IRCCode::UNKNOWNCOMMAND);
+            token.errMsg = token.command;
+            token.succes = false;
+            break;
+        case IRCCommand::CAP:
+        case IRCCommand::PONG:
+        case IRCCommand::WHOIS:
+            break;
     }
 }
 } // namespace
 
-std::vector<IRCMessage> parseIRCMessage(const std::string &msg) {
-    std::vector<IRCMessage> tokens;
-    std::string word;
-    const std::vector<std::string> lines = split(msg, "\r\n");
+bool parseMessage(const char *line, const std::size_t length,
+                  MessageView &msg) noexcept {
+    const std::size_t maxParams =
+        static_cast<std::size_t>(Defaults::MAXPARAMS);
+    std::size_t pos = 0;
 
-    for (const std::string &line : lines) {
-        IRCMessage parsed = {};
-        std::istringstream stream(line);
+    msg.prefix = StringView();
+    msg.paramCount = 0;
 
-        if (line[0] == ':') {
-            stream >> parsed.prefix;
-            parsed.prefix.erase(0, 1);
-        }
+    if (length > 0 && line[0] == ':') {
+        pos = skipWord(line, 1, length);
+        msg.prefix = StringView(line + 1, pos - 1);
+    }
 
-        if (stream >> parsed.command) {
-            while (stream >> word) {
-                if (word[0] == ':') {
-                    std::string rest;
-                    std::getline(stream, rest);
-                    try {
-                        parsed.params.emplace_back(word.substr(1) + rest);
-                    } catch (const std::out_of_range &e) {
-                        std::cerr << "Parser failed: " << e.what();
-                        return std::vector<IRCMessage>{};
-                    }
-                    break;
-                }
-
-                parsed.params.emplace_back(word);
-            }
+    pos = skipSpaces(line, pos, length);
+    const std::size_t commandEnd = skipWord(line, pos, length);
+    if (commandEnd == pos) {
+        return false;
+    }
+    msg.command = StringView(line + pos, commandEnd - pos);
+    msg.type = getCommand(msg.command);
+
+    pos = skipSpaces(line, commandEnd, length);
+    while (pos < length) {
+        // A ':' starts the trailing parameter; past the RFC limit of 15 the
+        // rest of the line is the last parameter either way.
+        if (line[pos] == ':' || msg.paramCount == maxParams - 1) {
+            const std::size_t start = line[pos] == ':' ? pos + 1 : pos;
+            msg.params[msg.paramCount++] =
+                StringView(line + start, length - start);
+            break;
         }
 
-        parsed.succes = true;
-        parsed.type = getCommand(parsed.command);
-        parsed.errMsg = "";
-        if (parsed.command != "") {
-            tokens.emplace_back(parsed);
-        }
+        const std::size_t end = skipWord(line, pos, length);
+        msg.params[msg.paramCount++] = StringView(line + pos, end - pos);
+        pos = skipSpaces(line, end, length);
+    }
+
+    return true;
+}
+
+bool parseIRCMessage(const char *line, const std::size_t length,
+                     IRCMessage &token) {
+    MessageView view;
+    if (parseMessage(line, length, view) != true) {
+        return false;
+    }
+
+    token.prefix.assign(view.prefix.data(), view.prefix.size());
+    token.command.assign(view.command.data(), view.command.size());
+    token.params.reserve(view.paramCount);
+    for (std::size_t i = 0; i < view.paramCount; ++i) {
+        token.params.emplace_back(view.params[i].data(), view.params[i].size());
     }
 
-    validateMessage(tokens);
+    token.succes = true;
+    token.type = view.type;
+    token.errMsg = "";
+    validateMessage(token);
 
-    return tokens;
+    return true;
 }
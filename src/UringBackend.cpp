@@ -0,0 +1,805 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <linux/io_uring.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "../include/Client.hpp"
+#include "../include/Logger.hpp"
+#include "../include/OutputBuffer.hpp"
+#include "../include/UringBackend.hpp"
+#include "../include/Utils.hpp"
+
+namespace {
+constexpr unsigned RING_ENTRIES = 1024;
+constexpr unsigned CQ_ENTRIES = 8192;
+constexpr std::uint16_t BUFFER_GROUP = 0;
+constexpr std::uint16_t BUFFER_COUNT = 1024; // power of two
+constexpr std::size_t BUFFER_SIZE = 2048;
+constexpr int AUX_EVENTS = 64;
+
+// user_data layout: operation in the top byte, the fd's generation in the
+// next 24 bits and the fd itself in the low 32, so completions that arrive
+// after a fd was removed and reused are recognised as stale.
+enum Op : std::uint8_t { ACCEPT = 1, RECV, SEND, POLL, CANCEL };
+
+// A Slot's gen wraps within these 24 bits, so it compares equal to what
+// genOf() reads back.
+constexpr std::uint32_t GEN_MASK = 0xFFFFFF;
+
+std::uint64_t userData(const Op op, const std::uint32_t gen, const int fd) {
+    return (static_cast<std::uint64_t>(op) << 56) |
+           (static_cast<std::uint64_t>(gen & GEN_MASK) << 32) |
+           static_cast<std::uint32_t>(fd);
+}
+
+Op opOf(const std::uint64_t data) {
+    return static_cast<Op>(data >> 56);
+}
+
+std::uint32_t genOf(const std::uint64_t data) {
+    return static_cast<std::uint32_t>((data >> 32) & GEN_MASK);
+}
+
+int fdOf(const std::uint64_t data) {
+    return static_cast<int>(data & 0xFFFFFFFF);
+}
+
+bool before(const ClientHandle &lhs, const ClientHandle &rhs) {
+    return lhs.fd != rhs.fd ? lhs.fd < rhs.fd
+                            : lhs.generation < rhs.generation;
+}
+
+bool same(const ClientHandle &lhs, const ClientHandle &rhs) {
+    return lhs.fd == rhs.fd && lhs.generation == rhs.generation;
+}
+
+// The backend whose loop runs on this thread, so notifyEpollUpdate can tell
+// its own appends from those made by another reactor.
+thread_local const UringBackend *t_owner{nullptr};
+} // namespace
+
+UringBackend::UringBackend(const Config &config)
+    : _ring_fd(-1), _aux_fd(-1), _wake_fd(-1),
+      _read_budget(config.readBudget) {
+}
+
+UringBackend::~UringBackend() {
+    if (_sqes != nullptr) {
+        munmap(_sqes, _sqes_size);
+    }
+    if (_cq_ptr != nullptr && _cq_ptr != _sq_ptr) {
+        munmap(_cq_ptr, _cq_size);
+    }
+    if (_sq_ptr != nullptr) {
+        munmap(_sq_ptr, _sq_size);
+    }
+
+    _ring_fd.clos();
+    if (_buf_ring != nullptr) {
+        munmap(_buf_ring, _buf_ring_size);
+    }
+}
+
+bool UringBackend::init(const int listenFD) {
+    if (_accept_guard.reserve() != true || _setupRing() != true ||
+        _setupBuffers() != true) {
+        return false;
+    }
+
+    _aux_fd = epoll_create1(0);
+    _wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (0 > _aux_fd.get() || 0 > _wake_fd.get()) {
+        std::cerr << "io_uring: aux epoll/eventfd failed: " << strerror(errno)
+                  << '\n';
+        return false;
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = _wake_fd.get();
+    if (0 > epoll_ctl(_aux_fd.get(), EPOLL_CTL_ADD, _wake_fd.get(), &ev)) {
+        std::cerr << "Epoll add failed: " << strerror(errno) << '\n';
+        return false;
+    }
+
+    _listen_fd = listenFD;
+    _armPoll();
+    _armAccept();
+    return true;
+}
+
+int UringBackend::wait(IOHandler &handler, const int timeout) {
+    t_owner = this;
+
+    if (_accept_paused && _accept_wake) {
+        _accept_paused = false;
+        if (_accept_deferred != true) {
+            _armAccept();
+        }
+    }
+
+    ++_pass;
+    bool pending = _deferred.empty() != true;
+    {
+        const std::lock_guard<std::mutex> lock(_mailbox_mutex);
+        pending = pending || _mailbox.empty() != true;
+    }
+
+    if (0 > _enter(pending ? 0 : 1, timeout)) {
+        return -1;
+    }
+
+    int count = _completeDeferred(handler);
+    unsigned head = *_cq_head;
+    unsigned tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+        const io_uring_cqe cqe = _cqes[head & _cq_mask];
+        ++head;
+        __atomic_store_n(_cq_head, head, __ATOMIC_RELEASE);
+
+        _complete(handler, cqe);
+        ++count;
+
+        if (head == tail) {
+            tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+        }
+    }
+
+    // An idle tick retries a paused accept, as does any client leaving.
+    if (count == 0) {
+        _accept_wake = true;
+    }
+
+    return count;
+}
+
+const char *UringBackend::getName() const noexcept {
+    return "io_uring";
+}
+
+IOStats UringBackend::getStats() const noexcept {
+    IOStats stats{};
+    _accept_guard.fillStats(stats);
+    return stats;
+}
+
+bool UringBackend::addClient(const ClientHandle client) {
+    const int fd = client.fd;
+    Slot &slot = _slot(fd);
+    slot.gen = (slot.gen + 1) & GEN_MASK;
+    slot.client = client.generation;
+    slot.sending = false;
+    slot.receiving = false;
+    slot.paused = false;
+    slot.throttled = false;
+    slot.deferred = 0;
+
+    _armRecv(fd);
+    return true;
+}
+
+void UringBackend::removeClient(const int fd) {
+    Slot &slot = _slot(fd);
+
+    // The ring holds its own reference to the socket while the multishot
+    // recv is armed, so closing the fd alone would never release it.
+    shutdown(fd, SHUT_RDWR);
+    _cancelRecv(fd);
+
+    slot.gen = (slot.gen + 1) & GEN_MASK;
+    slot.sending = false;
+    if (slot.carry != nullptr) {
+        _poolSend(std::move(slot.carry));
+    }
+    _accept_wake = true;
+}
+
+FlushResult UringBackend::flush(Client &client) {
+    const int fd = client.getFD();
+    Slot &slot = _slot(fd);
+
+    if (slot.sending) {
+        return FlushResult::PENDING;
+    }
+
+    std::unique_ptr<PendingSend> send = std::move(slot.carry);
+    {
+        const std::lock_guard<std::mutex> lock(client.getSendMutex());
+        if (send == nullptr) {
+            if (client.haveMessagesToSend() != true) {
+                client.setInFlight(0);
+                return FlushResult::DONE;
+            }
+
+            // The queue is handed over whole; appends made while this send
+            // is in flight start a fresh one and mark the client again.
+            send = _takeSend();
+            std::swap(send->out, client.getOutput());
+        }
+
+        // Still the client's SendQ until the kernel took it.
+        client.setInFlight(send->out.size());
+    }
+
+    io_uring_sqe *sqe = _getSqe();
+    if (sqe == nullptr) {
+        slot.carry = std::move(send);
+        const std::lock_guard<std::mutex> retry(_mailbox_mutex);
+        _mailbox.push_back(client.getHandle());
+        return FlushResult::PENDING;
+    }
+
+    send->msg = msghdr{};
+    send->msg.msg_iov = send->iov;
+    send->msg.msg_iovlen = send->out.fillIov(send->iov, IOV_BATCH);
+    if (Logger::enabled(LogLevel::TRACE)) {
+        logSend(fd, send->iov, send->msg.msg_iovlen);
+    }
+
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<std::uint64_t>(&send->msg);
+    sqe->len = 1;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = userData(SEND, slot.gen, fd);
+
+    _sends[sqe->user_data] = std::move(send);
+    slot.sending = true;
+    return FlushResult::PENDING;
+}
+
+void UringBackend::notifyEpollUpdate(const ClientHandle client) {
+    bool wake = false;
+
+    {
+        const std::lock_guard<std::mutex> lock(_mailbox_mutex);
+        wake = _mailbox.empty() && t_owner != this;
+        _mailbox.push_back(client);
+    }
+
+    if (wake) {
+        const std::uint64_t one = 1;
+        if (0 > write(_wake_fd.get(), &one, sizeof(one))) {
+            IRC_LOG(WARN) << "io_uring: wakeup failed: " << strerror(errno);
+        }
+    }
+}
+
+int UringBackend::getEpollFD() const noexcept {
+    return _aux_fd.get();
+}
+
+bool UringBackend::_setupRing() noexcept {
+    io_uring_params params{};
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = CQ_ENTRIES;
+
+    const int fd =
+        static_cast<int>(syscall(__NR_io_uring_setup, RING_ENTRIES, &params));
+    if (0 > fd) {
+        std::cerr << "io_uring setup failed: " << strerror(errno) << '\n';
+        return false;
+    }
+    _ring_fd = fd;
+
+    if (!(params.features & IORING_FEAT_EXT_ARG) ||
+        !(params.features & IORING_FEAT_NODROP)) {
+        std::cerr << "io_uring: kernel lacks EXT_ARG/NODROP support" << '\n';
+        return false;
+    }
+
+    _sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    _cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) {
+        _sq_size = _cq_size = std::max(_sq_size, _cq_size);
+    }
+
+    void *sq = mmap(nullptr, _sq_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (sq == MAP_FAILED) {
+        std::cerr << "io_uring: mmap sq failed: " << strerror(errno) << '\n';
+        return false;
+    }
+    _sq_ptr = sq;
+
+    if (single) {
+        _cq_ptr = _sq_ptr;
+    } else {
+        void *cq = mmap(nullptr, _cq_size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cq == MAP_FAILED) {
+            std::cerr << "io_uring: mmap cq failed: " << strerror(errno)
+                      << '\n';
+            return false;
+        }
+        _cq_ptr = cq;
+    }
+
+    _sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    void *sqes = mmap(nullptr, _sqes_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        std::cerr << "io_uring: mmap sqes failed: " << strerror(errno)
+                  << '\n';
+        return false;
+    }
+    _sqes = static_cast<io_uring_sqe *>(sqes);
+
+    char *sqBase = static_cast<char *>(_sq_ptr);
+    char *cqBase = static_cast<char *>(_cq_ptr);
+    _sq_head = reinterpret_cast<unsigned *>(sqBase + params.sq_off.head);
+    _sq_tail = reinterpret_cast<unsigned *>(sqBase + params.sq_off.tail);
+    _sq_array = reinterpret_cast<unsigned *>(sqBase + params.sq_off.array);
+    _sq_mask = *reinterpret_cast<unsigned *>(sqBase + params.sq_off.ring_mask);
+    _sq_entries = params.sq_entries;
+    _sq_local_tail = *_sq_tail;
+    _cq_head = reinterpret_cast<unsigned *>(cqBase + params.cq_off.head);
+    _cq_tail = reinterpret_cast<unsigned *>(cqBase + params.cq_off.tail);
+    _cq_mask = *reinterpret_cast<unsigned *>(cqBase + params.cq_off.ring_mask);
+    _cqes = reinterpret_cast<io_uring_cqe *>(cqBase + params.cq_off.cqes);
+
+    return true;
+}
+
+bool UringBackend::_setupBuffers() noexcept {
+    _buf_ring_size = BUFFER_COUNT * sizeof(io_uring_buf);
+    void *ring = mmap(nullptr, _buf_ring_size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ring == MAP_FAILED) {
+        std::cerr << "io_uring: mmap buffer ring failed: " << strerror(errno)
+                  << '\n';
+        return false;
+    }
+    _buf_ring = static_cast<io_uring_buf *>(ring);
+
+    io_uring_buf_reg reg{};
+    reg.ring_addr = reinterpret_cast<std::uint64_t>(ring);
+    reg.ring_entries = BUFFER_COUNT;
+    reg.bgid = BUFFER_GROUP;
+    if (0 > syscall(__NR_io_uring_register, _ring_fd.get(),
+                    IORING_REGISTER_PBUF_RING, &reg, 1)) {
+        std::cerr << "io_uring: buffer ring registration failed: "
+                  << strerror(errno) << '\n';
+        return false;
+    }
+
+    _buffers.resize(BUFFER_COUNT * BUFFER_SIZE);
+    for (std::uint16_t bid = 0; bid < BUFFER_COUNT; ++bid) {
+        _recycleBuffer(bid);
+    }
+
+    return true;
+}
+
+io_uring_sqe *UringBackend::_getSqe() noexcept {
+    unsigned head = __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+    if (_sq_local_tail - head >= _sq_entries) {
+        if (0 > _enter(0, 0)) {
+            return nullptr;
+        }
+
+        head = __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+        if (_sq_local_tail - head >= _sq_entries) {
+            IRC_LOG(WARN) << "io_uring: submission queue full";
+            return nullptr;
+        }
+    }
+
+    const unsigned index = _sq_local_tail & _sq_mask;
+    io_uring_sqe *sqe = &_sqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    _sq_array[index] = index;
+    ++_sq_local_tail;
+    ++_sq_pending;
+
+    return sqe;
+}
+
+// Submits everything queued since the last call and, when minComplete is
+// set, waits up to timeout milliseconds for a completion.
+int UringBackend::_enter(const unsigned minComplete,
+                         const int timeout) noexcept {
+    __atomic_store_n(_sq_tail, _sq_local_tail, __ATOMIC_RELEASE);
+
+    __kernel_timespec ts{};
+    ts.tv_sec = timeout / 1000;
+    ts.tv_nsec = static_cast<long long>(timeout % 1000) * 1000000;
+    io_uring_getevents_arg arg{};
+    arg.ts = reinterpret_cast<std::uint64_t>(&ts);
+
+    unsigned flags = 0;
+    void *argp = nullptr;
+    std::size_t argsz = 0;
+    if (minComplete > 0) {
+        flags = IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+        argp = &arg;
+        argsz = sizeof(arg);
+    }
+
+    const long ret = syscall(__NR_io_uring_enter, _ring_fd.get(), _sq_pending,
+                             minComplete, flags, argp, argsz);
+    if (0 > ret) {
+        if (errno == ETIME || errno == EINTR || errno == EBUSY) {
+            return 0;
+        }
+
+        IRC_LOG(ERROR) << "io_uring enter failed: " << strerror(errno);
+        return -1;
+    }
+
+    const unsigned submitted = static_cast<unsigned>(ret);
+    _sq_pending = submitted >= _sq_pending ? 0 : _sq_pending - submitted;
+    return static_cast<int>(ret);
+}
+
+UringBackend::Slot &UringBackend::_slot(const int fd) {
+    const std::size_t index = static_cast<std::size_t>(fd);
+    if (index >= _slots.size()) {
+        _slots.resize(index + 1);
+    }
+
+    return _slots[index];
+}
+
+ClientHandle UringBackend::_handle(const int fd) {
+    return ClientHandle{fd, _slot(fd).client};
+}
+
+std::unique_ptr<UringBackend::PendingSend> UringBackend::_takeSend() {
+    if (_send_pool.empty()) {
+        return std::unique_ptr<PendingSend>(new PendingSend());
+    }
+
+    std::unique_ptr<PendingSend> send = std::move(_send_pool.back());
+    _send_pool.pop_back();
+    return send;
+}
+
+void UringBackend::_poolSend(std::unique_ptr<PendingSend> send) noexcept {
+    send->out.clear();
+    try {
+        _send_pool.push_back(std::move(send));
+    } catch (const std::bad_alloc &) {
+        // Dropping it is fine: the pool only saves an allocation.
+    }
+}
+
+void UringBackend::_armAccept() noexcept {
+    io_uring_sqe *sqe = _getSqe();
+    if (sqe == nullptr) {
+        return;
+    }
+
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = _listen_fd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    sqe->user_data = userData(ACCEPT, 0, _listen_fd);
+    _accept_armed = true;
+}
+
+void UringBackend::_armRecv(const int fd) noexcept {
+    io_uring_sqe *sqe = _getSqe();
+    if (sqe == nullptr) {
+        return;
+    }
+
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BUFFER_GROUP;
+    sqe->user_data = userData(RECV, _slot(fd).gen, fd);
+    _slot(fd).receiving = true;
+}
+
+// Ends the multishot recv; its final completion clears `receiving`.
+void UringBackend::_cancelRecv(const int fd) noexcept {
+    io_uring_sqe *sqe = _getSqe();
+    if (sqe == nullptr) {
+        return;
+    }
+
+    const std::uint32_t gen = _slot(fd).gen;
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = userData(RECV, gen, fd);
+    sqe->user_data = userData(CANCEL, gen, fd);
+}
+
+void UringBackend::_armPoll() noexcept {
+    io_uring_sqe *sqe = _getSqe();
+    if (sqe == nullptr) {
+        return;
+    }
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = _aux_fd.get();
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->poll32_events = EPOLLIN;
+    sqe->user_data = userData(POLL, 0, _aux_fd.get());
+}
+
+void UringBackend::_recycleBuffer(const std::uint16_t bid) noexcept {
+    io_uring_buf &buf = _buf_ring[_buf_tail & (BUFFER_COUNT - 1)];
+    buf.addr = reinterpret_cast<std::uint64_t>(_buffers.data() +
+                                               bid * BUFFER_SIZE);
+    buf.len = static_cast<std::uint32_t>(BUFFER_SIZE);
+    buf.bid = bid;
+
+    ++_buf_tail;
+    __atomic_store_n(&reinterpret_cast<io_uring_buf_ring *>(_buf_ring)->tail,
+                     _buf_tail, __ATOMIC_RELEASE);
+}
+
+void UringBackend::_complete(IOHandler &handler, const io_uring_cqe &cqe) {
+    const bool more = (cqe.flags & IORING_CQE_F_MORE) != 0;
+
+    switch (opOf(cqe.user_data)) {
+        case ACCEPT:
+            // The ring reserves the fd before it looks for a connection, so
+            // at the limit every re-arm fails at once. Pending connections
+            // are shed; once none are left accept waits for an fd to free.
+            if (cqe.res >= 0) {
+                _accept_guard.accepted();
+                handler.onAccept(cqe.res, nullptr);
+            } else if (cqe.res == -EMFILE || cqe.res == -ENFILE) {
+                if (_accept_guard.shed(_listen_fd) != true) {
+                    _accept_paused = true;
+                    _accept_wake = false;
+                }
+            } else if (cqe.res != -ECANCELED) {
+                _accept_guard.failed();
+                IRC_LOG(WARN) << "Accept failed: " << strerror(-cqe.res);
+            }
+            if (!more) {
+                _accept_armed = false;
+                if (!_accept_paused && !_accept_deferred) {
+                    _armAccept();
+                }
+            }
+            break;
+        case RECV:
+            _completeRecv(handler, cqe);
+            break;
+        case SEND:
+            _completeSend(handler, cqe);
+            break;
+        case POLL:
+            _drainAux(handler);
+            if (!more) {
+                _armPoll();
+            }
+            break;
+        case CANCEL:
+            break;
+    }
+}
+
+void UringBackend::_completeRecv(IOHandler &handler, const io_uring_cqe &cqe) {
+    const int fd = fdOf(cqe.user_data);
+    const std::uint32_t gen = genOf(cqe.user_data);
+    const bool more = (cqe.flags & IORING_CQE_F_MORE) != 0;
+    const bool hasBuffer = (cqe.flags & IORING_CQE_F_BUFFER) != 0;
+    const std::uint16_t bid =
+        static_cast<std::uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+
+    Slot &current = _slot(fd);
+    if (current.gen != gen) {
+        if (hasBuffer) {
+            _recycleBuffer(bid);
+        }
+        return;
+    }
+
+    // Over budget, or behind completions that were: kept for the next
+    // wait(), and the recv is stopped so the kernel keeps the rest.
+    if (current.pass != _pass) {
+        current.pass = _pass;
+        current.received = 0;
+    }
+    if (current.deferred != 0 || current.received >= _read_budget) {
+        _deferred.push_back(cqe);
+        ++current.deferred;
+        if (current.throttled != true) {
+            current.throttled = true;
+            if (current.receiving) {
+                _cancelRecv(fd);
+            }
+        }
+        return;
+    }
+
+    if (cqe.res > 0 && hasBuffer) {
+        current.received += static_cast<std::size_t>(cqe.res);
+        handler.onRecv(_handle(fd), _buffers.data() + bid * BUFFER_SIZE,
+                       static_cast<std::size_t>(cqe.res));
+        _recycleBuffer(bid);
+    } else if (cqe.res == 0) {
+        return handler.onClosed(_handle(fd));
+    } else if (cqe.res != -ENOBUFS && cqe.res != -EAGAIN &&
+               cqe.res != -ECANCELED) {
+        IRC_LOG(WARN) << "Error while recv: " << strerror(-cqe.res);
+        return handler.onClosed(_handle(fd));
+    }
+
+    // The handler may have removed the client; only re-arm if it is the
+    // same connection, the kernel ended the multishot request and the
+    // client is neither paused nor throttled.
+    Slot &slot = _slot(fd);
+    if (!more && slot.gen == gen) {
+        slot.receiving = false;
+        if (slot.paused != true && slot.throttled != true) {
+            _armRecv(fd);
+        }
+    }
+}
+
+// Hands over what earlier passes deferred, oldest first and under this
+// pass's budgets; what still does not fit is deferred again. A client
+// whose backlog is through gets its recv back.
+int UringBackend::_completeDeferred(IOHandler &handler) {
+    if (_deferred.empty()) {
+        return 0;
+    }
+
+    _replay.swap(_deferred);
+    for (const io_uring_cqe &cqe : _replay) {
+        _slot(fdOf(cqe.user_data)).deferred = 0;
+    }
+    for (const io_uring_cqe &cqe : _replay) {
+        _completeRecv(handler, cqe);
+    }
+
+    for (const io_uring_cqe &cqe : _replay) {
+        const int fd = fdOf(cqe.user_data);
+        Slot &slot = _slot(fd);
+        if (slot.throttled && slot.deferred == 0) {
+            slot.throttled = false;
+            if (slot.receiving != true && slot.paused != true) {
+                _armRecv(fd);
+            }
+        }
+    }
+
+    const int count = static_cast<int>(_replay.size());
+    _replay.clear();
+    return count;
+}
+
+void UringBackend::_completeSend(IOHandler &handler, const io_uring_cqe &cqe) {
+    const auto it = _sends.find(cqe.user_data);
+    if (it == _sends.end()) {
+        return;
+    }
+
+    std::unique_ptr<PendingSend> send = std::move(it->second);
+    _sends.erase(it);
+
+    const int fd = fdOf(cqe.user_data);
+    Slot &slot = _slot(fd);
+    if (slot.gen != genOf(cqe.user_data)) {
+        return _poolSend(std::move(send));
+    }
+    slot.sending = false;
+
+    if (cqe.res == -EAGAIN) {
+        slot.carry = std::move(send);
+        return handler.onWritable(_handle(fd));
+    }
+
+    if (0 > cqe.res) {
+        IRC_LOG(WARN) << "Error while sending: " << strerror(-cqe.res);
+        _poolSend(std::move(send));
+        return handler.onClosed(_handle(fd));
+    }
+
+    send->out.consume(static_cast<std::size_t>(cqe.res));
+    if (send->out.empty() != true) {
+        slot.carry = std::move(send);
+    } else {
+        _poolSend(std::move(send));
+    }
+
+    handler.onWritable(_handle(fd));
+}
+
+void UringBackend::_drainAux(IOHandler &handler) {
+    epoll_event events[AUX_EVENTS];
+    int nfds = AUX_EVENTS;
+
+    while (nfds == AUX_EVENTS) {
+        nfds = epoll_wait(_aux_fd.get(), events, AUX_EVENTS, 0);
+        for (int index = 0; index < nfds; ++index) {
+            if (events[index].data.fd == _wake_fd.get()) {
+                std::uint64_t value = 0;
+                if (0 > read(_wake_fd.get(), &value, sizeof(value)) &&
+                    errno != EAGAIN) {
+                    IRC_LOG(WARN) << "io_uring: eventfd read failed: "
+                                  << strerror(errno);
+                }
+                continue;
+            }
+
+            handler.onAux(events[index].data.fd, events[index].events);
+        }
+    }
+}
+
+// A paused client's multishot recv is cancelled; its completion then leaves
+// it unarmed until the client is resumed.
+void UringBackend::pauseRecv(const int fd, const bool paused) {
+    Slot &slot = _slot(fd);
+    if (slot.paused == paused) {
+        return;
+    }
+
+    slot.paused = paused;
+    if (paused != true) {
+        if (slot.receiving != true && slot.throttled != true) {
+            _armRecv(fd);
+        }
+        return;
+    }
+
+    if (slot.receiving) {
+        _cancelRecv(fd);
+    }
+}
+
+// Cancelling the multishot accept leaves new connections queued on the
+// listener; its final completion comes back as -ECANCELED.
+void UringBackend::deferAccept(const bool deferred) {
+    if (_accept_deferred == deferred) {
+        return;
+    }
+
+    _accept_deferred = deferred;
+    if (deferred != true) {
+        if (!_accept_armed && !_accept_paused) {
+            _armAccept();
+        }
+        return;
+    }
+
+    io_uring_sqe *sqe = _accept_armed ? _getSqe() : nullptr;
+    if (sqe != nullptr) {
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = userData(ACCEPT, 0, _listen_fd);
+        sqe->user_data = userData(CANCEL, 0, _listen_fd);
+    }
+}
+
+void UringBackend::flushPending(IOHandler &handler) {
+    {
+        const std::lock_guard<std::mutex> lock(_mailbox_mutex);
+        _ready.swap(_mailbox);
+    }
+
+    std::sort(_ready.begin(), _ready.end(), before);
+    _ready.erase(std::unique(_ready.begin(), _ready.end(), same),
+                 _ready.end());
+    for (const ClientHandle &client : _ready) {
+        handler.onWritable(client);
+    }
+    _ready.clear();
+}
@@ -1,16 +1,33 @@
 #include <cerrno>
 #include <cstdint>
 #include <cstdlib>
-#include <iostream>
 #include <stdexcept>
 #include <string>
 #include <vector>
 
+#include <sys/uio.h>
+
+#include "../include/Logger.hpp"
+#include "../include/StringView.hpp"
 #include "../include/Utils.hpp"
 
+namespace {
+// std::stoul takes a sign and negates in unsigned arithmetic, so "-1" would
+// read as the largest value instead of failing.
+bool isNegative(const std::string &str) noexcept {
+    const std::size_t first = str.find_first_not_of(" \t\n\v\f\r");
+    return first != std::string::npos && str[first] == '-';
+}
+} // namespace
+
 std::uint16_t toUint16(const std::string &str) {
     errno = 0;
 
+    if (isNegative(str)) {
+        errno = EINVAL;
+        return 0;
+    }
+
     try {
         std::size_t pos = 0;
         const unsigned long value = std::stoul(str, &pos, BASE);
@@ -38,6 +55,11 @@ std::uint16_t toUint16(const std::string &str) {
 std::size_t toSizeT(const std::string &str) {
     errno = 0;
 
+    if (isNegative(str)) {
+        errno = EINVAL;
+        return 0;
+    }
+
     try {
         std::size_t pos = 0;
         const unsigned long value = std::stoul(str, &pos, BASE);
@@ -67,7 +89,7 @@ std::vector<std::string> split(const std::string &str,
         try {
             lines.push_back(str.substr(prev, pos - prev));
         } catch (const std::out_of_range &e) {
-            std::cerr << "Failed to split: " << e.what() << '\n';
+            IRC_LOG(ERROR) << "Failed to split: " << e.what();
             return std::vector<std::string>{};
         }
         prev = pos + delim.length();
@@ -76,9 +98,18 @@ std::vector<std::string> split(const std::string &str,
     try {
         lines.push_back(str.substr(prev));
     } catch (const std::out_of_range &e) {
-        std::cerr << "Failed to split: " << e.what() << '\n';
+        IRC_LOG(ERROR) << "Failed to split: " << e.what();
         return std::vector<std::string>{};
     }
 
     return lines;
 }
+
+void logSend(const int fd, const iovec *iov, const std::size_t count) noexcept {
+    LogLine line(LogLevel::TRACE);
+    line << "send to fd: " << fd << ": ";
+    for (std::size_t index = 0; index < count; ++index) {
+        line << StringView(static_cast<const char *>(iov[index].iov_base),
+                           iov[index].iov_len);
+    }
+}
@@ -2,6 +2,8 @@
 #include <iostream>
 #include <string>
 
+#include "../include/Config.hpp"
+#include "../include/Logger.hpp"
 #include "../include/Server.hpp"
 
 int main(const int argc, char **argv) {
@@ -14,7 +16,9 @@ int main(const int argc, char **argv) {
     try {
         const std::string arg1 = argv[1];
         std::string arg2 = argv[2];
-        Server server = Server(arg1, arg2);
+        const Config config = loadConfig();
+        const Logger logger(config); // outlives the server's threads
+        Server server = Server(arg1, arg2, config);
 
         if (server.init() != true) {
             return 2;
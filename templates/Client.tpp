@@ -0,0 +1,24 @@
+#ifndef CLIENT_TPP
+#define CLIENT_TPP
+
+#include <mutex>
+
+template <typename Writer>
+void Client::appendWith(Writer &&writer) noexcept {
+    const std::lock_guard<std::mutex> lock(_send_mutex);
+
+    // The line's size is only known once written: admit it while the queue
+    // still has room for one more byte.
+    if (_admit(1) != true) {
+        return;
+    }
+
+    const bool wasEmpty = _output.empty();
+    writer(_output);
+    _queued();
+    if (wasEmpty && _output.empty() != true && _epollNotifier) {
+        _epollNotifier->notifyEpollUpdate(getHandle());
+    }
+}
+
+#endif // CLIENT_TPP
@@ -0,0 +1,61 @@
+#ifndef LINEBUFFER_TPP
+#define LINEBUFFER_TPP
+
+#include <cstddef>
+#include <cstring>
+
+template <typename Sink>
+void LineBuffer::feed(const char *data, const std::size_t length,
+                      Sink &&sink) {
+    std::size_t pos = 0;
+
+    while (pos < length) {
+        const void *found = std::memchr(data + pos, '\n', length - pos);
+        if (found == nullptr) {
+            if (_keep(data + pos, length - pos) != true) {
+                sink(nullptr, 0, true);
+            }
+            break;
+        }
+
+        const std::size_t lf =
+            static_cast<std::size_t>(static_cast<const char *>(found) - data);
+        const bool crlf = lf > pos ? data[lf - 1] == '\r'
+                                   : (_tail.empty() != true &&
+                                      _tail[_tail.size() - 1] == '\r');
+
+        if (crlf != true) {
+            // A bare LF is part of the line, as it always was.
+            if (_keep(data + pos, lf + 1 - pos) != true) {
+                sink(nullptr, 0, true);
+            }
+        } else if (_skipping) {
+            _skipping = false;
+            _tail.clear();
+        } else if (_tail.empty()) {
+            const std::size_t size = lf - 1 - pos;
+            if (size > _limit) {
+                sink(nullptr, 0, true);
+            } else {
+                sink(data + pos, size, false);
+            }
+        } else {
+            const std::size_t size = _tail.size() + lf - pos - 1;
+            if (size > _limit) {
+                sink(nullptr, 0, true);
+            } else {
+                _tail.append(data + pos, lf - pos);
+                sink(_tail.data(), size, false);
+            }
+            _tail.clear();
+        }
+
+        pos = lf + 1;
+    }
+
+    if (_tail.empty()) {
+        _release();
+    }
+}
+
+#endif // !LINEBUFFER_TPP
@@ -0,0 +1,21 @@
+#ifndef LOGGER_TPP
+#define LOGGER_TPP
+
+#include <type_traits>
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value &&
+                            !std::is_same<T, char>::value &&
+                            !std::is_same<T, bool>::value,
+                        LogLine &>::type
+LogLine::operator<<(const T value) noexcept {
+    if (std::is_signed<T>::value) {
+        _number(static_cast<long long>(value));
+    } else {
+        _number(static_cast<unsigned long long>(value));
+    }
+
+    return *this;
+}
+
+#endif // LOGGER_TPP
@@ -0,0 +1,38 @@
+#ifndef REPLYCATALOG_TPP
+#define REPLYCATALOG_TPP
+
+#include <string>
+
+template <typename Sink>
+void writeReply(const ReplyFormat &format, const Client *client,
+                const std::string &value, const std::string &msg,
+                Sink &&sink) {
+    for (const ReplyPiece &piece : format.pieces) {
+        const std::string *slot = nullptr;
+
+        if (piece.kind == ReplyPiece::TEXT) {
+            sink(format.text.data() + piece.offset, piece.length);
+            continue;
+        } else if (piece.kind == ReplyPiece::VALUE) {
+            slot = &value;
+        } else if (piece.kind == ReplyPiece::MSG) {
+            slot = &msg;
+        } else if (client == nullptr) {
+            continue;
+        } else if (piece.kind == ReplyPiece::NICK) {
+            slot = &client->getNickname();
+        } else if (piece.kind == ReplyPiece::NICK_OR_STAR) {
+            slot = &client->getNickname();
+            if (slot->empty()) {
+                sink("*", 1);
+                continue;
+            }
+        } else {
+            slot = &client->getFullID();
+        }
+
+        sink(slot->data(), slot->size());
+    }
+}
+
+#endif // REPLYCATALOG_TPP
@@ -0,0 +1,186 @@
+#ifndef TIMERWHEEL_TPP
+#define TIMERWHEEL_TPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+template <typename T>
+constexpr std::uint32_t TimerWheel<T>::NONE;
+template <typename T>
+constexpr std::uint32_t TimerWheel<T>::LEVELS;
+template <typename T>
+constexpr std::uint32_t TimerWheel<T>::SLOT_BITS;
+template <typename T>
+constexpr std::uint32_t TimerWheel<T>::SLOTS;
+template <typename T>
+constexpr std::uint32_t TimerWheel<T>::HEADS;
+
+template <typename T>
+TimerWheel<T>::TimerWheel(const std::chrono::milliseconds tick)
+    : _tick(tick.count() > 0 ? tick : std::chrono::milliseconds(1)),
+      _origin(Clock::now()), _nodes(HEADS) {
+    for (std::uint32_t head = 0; head < HEADS; ++head) {
+        _nodes[head].next = head;
+        _nodes[head].prev = head;
+    }
+}
+
+template <typename T>
+std::uint32_t TimerWheel<T>::arm(const std::chrono::milliseconds delay,
+                                 T value) {
+    const std::uint32_t most = (1U << (SLOT_BITS * LEVELS)) - 1;
+    std::uint64_t ticks = 1;
+    if (delay > _tick) {
+        ticks = static_cast<std::uint64_t>((delay.count() + _tick.count() - 1) /
+                                           _tick.count());
+    }
+    if (ticks > most) {
+        ticks = most;
+    }
+
+    std::uint32_t id = _free;
+    if (id != NONE) {
+        _free = _nodes[id].next;
+        _nodes[id].value = std::move(value);
+    } else {
+        id = static_cast<std::uint32_t>(_nodes.size());
+        _nodes.push_back(Node{std::move(value), NONE, NONE, 0});
+    }
+
+    _nodes[id].expires = _next + static_cast<std::uint32_t>(ticks);
+    _link(id);
+    ++_armed;
+    return id;
+}
+
+template <typename T>
+void TimerWheel<T>::cancel(const std::uint32_t id) noexcept {
+    if (id < HEADS || id >= _nodes.size() || _nodes[id].prev == id) {
+        return;
+    }
+
+    _unlink(id);
+    _release(id);
+}
+
+template <typename T>
+template <typename Fire>
+void TimerWheel<T>::advance(const Clock::time_point now, Fire &&fire) {
+    if (now < _origin) {
+        return;
+    }
+
+    const std::uint64_t elapsed = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(now - _origin)
+            .count() /
+        _tick.count());
+    const std::uint32_t target = static_cast<std::uint32_t>(elapsed);
+
+    while (static_cast<std::int32_t>(target - _next) >= 0) {
+        const std::uint32_t slot = _next & (SLOTS - 1);
+        if (slot == 0) {
+            for (std::uint32_t level = 1; level < LEVELS; ++level) {
+                if (_cascade(level) != 0) {
+                    break;
+                }
+            }
+        }
+
+        Node &head = _nodes[slot];
+        while (head.next != slot) {
+            const std::uint32_t id = head.next;
+            _unlink(id);
+            T value = std::move(_nodes[id].value);
+            _release(id);
+            fire(value);
+        }
+
+        ++_next;
+    }
+}
+
+template <typename T>
+std::size_t TimerWheel<T>::size() const noexcept {
+    return _armed;
+}
+
+template <typename T>
+std::chrono::milliseconds
+TimerWheel<T>::untilTick(const Clock::time_point now,
+                         const std::chrono::milliseconds most) const noexcept {
+    if (_armed == 0) {
+        return most;
+    }
+
+    const Clock::time_point due = _origin + _tick * _next;
+    if (due <= now) {
+        return std::chrono::milliseconds(0);
+    }
+
+    const auto wait =
+        std::chrono::duration_cast<std::chrono::milliseconds>(due - now) +
+        std::chrono::milliseconds(1);
+    return wait < most ? wait : most;
+}
+
+// Into the lowest level whose range reaches the expiry, counted from the
+// next tick to run, as in the classic BSD and Linux wheels.
+template <typename T>
+void TimerWheel<T>::_link(const std::uint32_t id) noexcept {
+    Node &node = _nodes[id];
+    const std::uint32_t delta = node.expires - _next;
+
+    std::uint32_t level = 0;
+    while (level + 1 < LEVELS && delta >= (1U << (SLOT_BITS * (level + 1)))) {
+        ++level;
+    }
+
+    const std::uint32_t head =
+        level * SLOTS + ((node.expires >> (SLOT_BITS * level)) & (SLOTS - 1));
+    node.next = head;
+    node.prev = _nodes[head].prev;
+    _nodes[node.prev].next = id;
+    _nodes[head].prev = id;
+}
+
+template <typename T>
+void TimerWheel<T>::_unlink(const std::uint32_t id) noexcept {
+    Node &node = _nodes[id];
+    _nodes[node.prev].next = node.next;
+    _nodes[node.next].prev = node.prev;
+}
+
+template <typename T>
+void TimerWheel<T>::_release(const std::uint32_t id) noexcept {
+    Node &node = _nodes[id];
+    node.value = T();
+    node.prev = id; // not armed, see cancel()
+    node.next = _free;
+    _free = id;
+    --_armed;
+}
+
+// Moves the slot of `level` that comes due with the next tick one level
+// down, or further; returns that slot's index, so the caller knows whether
+// the level above has gone round too.
+template <typename T>
+std::uint32_t TimerWheel<T>::_cascade(const std::uint32_t level) noexcept {
+    const std::uint32_t slot = (_next >> (SLOT_BITS * level)) & (SLOTS - 1);
+    const std::uint32_t head = level * SLOTS + slot;
+
+    std::uint32_t id = _nodes[head].next;
+    _nodes[head].next = head;
+    _nodes[head].prev = head;
+    while (id != head) {
+        const std::uint32_t next = _nodes[id].next;
+        _link(id);
+        id = next;
+    }
+
+    return slot;
+}
+
+#endif // TIMERWHEEL_TPP